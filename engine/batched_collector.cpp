@@ -3,54 +3,69 @@
 #include <algorithm>
 #include <cstring>
 #include <stdexcept>
-
-#include <pybind11/numpy.h>
-
-namespace {
-
-void zero_fill(py::array& arr) {
-    py::buffer_info info = arr.request();
-    std::memset(info.ptr, 0, info.size * info.itemsize);
-}
-
-}  // namespace
+#include <string>
+#include <utility>
 
 BatchedTetrisCollector::BatchedTetrisCollector(size_t num_workers,
                                                uint32_t max_steps,
                                                uint8_t queue_size,
-                                               uint32_t seed_base)
+                                               uint32_t seed_base,
+                                               ObsMode obs_mode,
+                                               ActionMode action_mode,
+                                               PieceRandomizer randomizer,
+                                               ObsDtype obs_dtype,
+                                               bool pin_workers,
+                                               bool huge_pages)
     : max_steps_(max_steps),
       queue_size_(queue_size),
+      obs_mode_(obs_mode),
+      action_mode_(action_mode),
+      obs_dtype_(obs_dtype),
+      huge_pages_(huge_pages),
       obs_dim_(0),
+      stored_obs_dim_(0),
+      job_queue_(std::max<size_t>(64, 2 * num_workers)),
+      result_queue_(job_queue_.capacity() + num_workers),
       policy_callback_(py::none()) {
     if (num_workers == 0) {
         throw std::invalid_argument("num_workers must be > 0");
     }
-    envs_.reserve(num_workers);
-    buffers_.reserve(num_workers);
-    workers_.reserve(num_workers);
-
-    for (size_t i = 0; i < num_workers; ++i) {
-        envs_.emplace_back(std::make_unique<TetrisGame>(TimeManager::Mode::SIMULATION,
-                                                        queue_size_,
-                                                        seed_base + static_cast<uint32_t>(i)));
+    if (obs_mode_ == ObsMode::FEATURES && obs_dtype_ != ObsDtype::FLOAT32) {
+        throw std::invalid_argument("FEATURES observations are floats; obs_dtype must be FLOAT32");
     }
+    if (pin_workers) {
+        // Consecutive workers on consecutive allowed CPUs, wrapping around
+        const std::vector<int> cpus = allowedCpus();
+        for (size_t i = 0; i < num_workers; ++i) {
+            worker_cpus_.push_back(cpus[i % cpus.size()]);
+        }
+    }
+    envs_.resize(num_workers);
+    buffers_.resize(num_workers);
+    workers_.reserve(num_workers);
 
-    obs_dim_ = compute_obs_dim(envs_.front()->obs);
+    obs_dim_ = obs_mode_ == ObsMode::FEATURES
+                   ? static_cast<uint32_t>(TetrisGame::featureSize(queue_size_))
+                   : compute_obs_dim(Observation(queue_size_));
+    stored_obs_dim_ = obs_dtype_ == ObsDtype::PACKED ? static_cast<uint32_t>(Observation::packedSize(queue_size_))
+                                                     : obs_dim_;
 
+    max_batch_size_ = num_workers;
     for (size_t i = 0; i < num_workers; ++i) {
-        WorkerBuffers buf;
-        buf.observations.resize(static_cast<size_t>(max_steps_) * obs_dim_);
-        buf.rewards.resize(max_steps_);
-        buf.actions.resize(max_steps_);
-        buf.log_probs.resize(max_steps_);
-        buf.values.resize(max_steps_);
-        buf.dones.resize(max_steps_);
-        buffers_.push_back(std::move(buf));
+        futures_.push_back(std::make_unique<PolicyFuture>());
     }
 
     for (size_t i = 0; i < num_workers; ++i) {
-        workers_.emplace_back(&BatchedTetrisCollector::worker_loop, this, i);
+        workers_.emplace_back(&BatchedTetrisCollector::worker_loop, this, i, seed_base + static_cast<uint32_t>(i),
+                              randomizer);
+    }
+    {
+        std::unique_lock<std::mutex> lock(init_mutex_);
+        init_cv_.wait(lock, [&] { return workers_ready_ == num_workers; });
+    }
+    if (init_error_) {
+        close();
+        std::rethrow_exception(init_error_);
     }
 }
 
@@ -58,54 +73,250 @@ BatchedTetrisCollector::~BatchedTetrisCollector() {
     close();
 }
 
+void BatchedTetrisCollector::set_max_batch_size(size_t size) {
+    if (size == 0) {
+        throw std::invalid_argument("max_batch_size must be > 0");
+    }
+    max_batch_size_ = size;
+}
+
 void BatchedTetrisCollector::close() {
+    shutting_down_ = true;
     {
-        std::lock_guard<std::mutex> lock(job_mutex_);
-        shutting_down_ = true;
+        // A DYNAMIC collection in flight: fail its queued requests so the
+        // workers can finish, and let the broker return
+        std::lock_guard<std::mutex> lock(broker_mutex_);
+        broker_failed_ = true;
+        episodes_left_ = 0;
+        for (const PolicyRequest& request : pending_requests_) {
+            PolicyFuture& future = *futures_[request.worker];
+            std::lock_guard<std::mutex> future_lock(future.mutex);
+            future.failed = true;
+            future.ready = true;
+            future.cv.notify_one();
+        }
+        pending_requests_.clear();
     }
-    job_cv_.notify_all();
-    result_cv_.notify_all();
-    for (auto& worker : workers_) {
-        if (worker.joinable()) {
-            worker.join();
+    broker_cv_.notify_all();
+    job_queue_.close();
+    result_queue_.close();
+
+    // Workers and coordinators of submitted batches may need the GIL to finish
+    const auto join_all = [this] {
+        for (auto& worker : workers_) {
+            if (worker.joinable()) {
+                worker.join();
+            }
         }
+        for (auto& submission : submissions_) {
+            if (submission.second->coordinator.joinable()) {
+                submission.second->coordinator.join();
+            }
+        }
+    };
+    if (PyGILState_Check()) {
+        py::gil_scoped_release release;
+        join_all();
+    } else {
+        join_all();
     }
     workers_.clear();
 }
 
-py::dict BatchedTetrisCollector::request_episodes(size_t num_episodes, py::function policy_fn) {
+py::dict BatchedTetrisCollector::request_episodes(size_t num_episodes, py::object policy_fn,
+                                                  PolicyBatching batching) {
     if (num_episodes == 0) {
         throw std::invalid_argument("num_episodes must be > 0");
     }
+    if (collecting()) {
+        throw std::runtime_error("a submitted batch is still collecting; wait() for it first");
+    }
 
-    policy_callback_ = std::move(policy_fn);
+    select_policy(std::move(policy_fn));
+    if (use_native_) {
+        batching = PolicyBatching::PER_WORKER;
+    }
+    py::dict batch = begin_collection(num_episodes, batching);
+    try {
+        py::gil_scoped_release release;
+        collect(num_episodes, batching);
+    } catch (...) {
+        policy_callback_ = py::none();
+        throw;
+    }
+    policy_callback_ = py::none();
+    return batch;
+}
 
-    {
-        std::lock_guard<std::mutex> lock(job_mutex_);
-        for (size_t i = 0; i < num_episodes; ++i) {
-            job_queue_.push(EpisodeJob{next_job_id_++, max_steps_});
+uint64_t BatchedTetrisCollector::submit(size_t num_episodes, py::object policy_fn, PolicyBatching batching,
+                                        int64_t policy_version) {
+    if (num_episodes == 0) {
+        throw std::invalid_argument("num_episodes must be > 0");
+    }
+    if (shutting_down_) {
+        throw std::runtime_error("collector is closed");
+    }
+    if (collecting()) {
+        throw std::runtime_error("a submitted batch is still collecting; wait() for it first");
+    }
+
+    select_policy(std::move(policy_fn));
+    if (use_native_) {
+        batching = PolicyBatching::PER_WORKER;
+    }
+    py::dict arrays = begin_collection(num_episodes, batching);
+    return start_submission(std::move(arrays), num_episodes, policy_version,
+                            [this, num_episodes, batching] { collect(num_episodes, batching); });
+}
+
+py::dict BatchedTetrisCollector::request_segments(uint32_t num_steps, py::object policy_fn) {
+    if (num_steps == 0) {
+        throw std::invalid_argument("num_steps must be > 0");
+    }
+    if (collecting()) {
+        throw std::runtime_error("a submitted batch is still collecting; wait() for it first");
+    }
+
+    select_policy(std::move(policy_fn));
+    py::dict batch = begin_segments(num_steps);
+    try {
+        collect_segments(num_steps);
+    } catch (...) {
+        policy_callback_ = py::none();
+        throw;
+    }
+    policy_callback_ = py::none();
+    return batch;
+}
+
+uint64_t BatchedTetrisCollector::submit_segments(uint32_t num_steps, py::object policy_fn,
+                                                 int64_t policy_version) {
+    if (num_steps == 0) {
+        throw std::invalid_argument("num_steps must be > 0");
+    }
+    if (shutting_down_) {
+        throw std::runtime_error("collector is closed");
+    }
+    if (collecting()) {
+        throw std::runtime_error("a submitted batch is still collecting; wait() for it first");
+    }
+
+    select_policy(std::move(policy_fn));
+    py::dict arrays = begin_segments(num_steps);
+    return start_submission(std::move(arrays), 0, policy_version, [this, num_steps] {
+        py::gil_scoped_acquire gil;
+        collect_segments(num_steps);
+    });
+}
+
+void BatchedTetrisCollector::set_policy_weights(std::shared_ptr<const MlpPolicy> policy) {
+    if (policy) {
+        if (action_mode_ != ActionMode::PRIMITIVE) {
+            throw std::invalid_argument("the native policy picks primitive actions; action_mode must be PRIMITIVE");
+        }
+        if (policy->inputSize() != obs_dim_) {
+            throw std::invalid_argument("native policy takes " + std::to_string(policy->inputSize()) +
+                                        " inputs but observations have " + std::to_string(obs_dim_));
+        }
+        if (policy->numActions() != num_actions()) {
+            throw std::invalid_argument("native policy has " + std::to_string(policy->numActions()) +
+                                        " actions but the env has " + std::to_string(num_actions()));
+        }
+    }
+    std::lock_guard<std::mutex> lock(native_mutex_);
+    native_policy_ = std::move(policy);
+}
+
+std::shared_ptr<const MlpPolicy> BatchedTetrisCollector::native_policy() const {
+    std::lock_guard<std::mutex> lock(native_mutex_);
+    return native_policy_;
+}
+
+void BatchedTetrisCollector::select_policy(py::object policy_fn) {
+    if (policy_fn.is_none()) {
+        if (!native_policy()) {
+            throw std::invalid_argument("policy_fn is None but no native policy is set; call set_policy_weights");
+        }
+        use_native_ = true;
+    } else {
+        if (!PyCallable_Check(policy_fn.ptr())) {
+            throw std::invalid_argument("policy_fn must be callable, or None for the native policy");
         }
+        use_native_ = false;
     }
-    job_cv_.notify_all();
+    policy_callback_ = std::move(policy_fn);
+}
 
-    std::vector<EpisodeResult> finished;
-    finished.reserve(num_episodes);
+uint64_t BatchedTetrisCollector::start_submission(py::dict arrays, size_t num_episodes, int64_t policy_version,
+                                                  std::function<void()> collect_fn) {
+    auto submission = std::make_unique<SubmittedBatch>();
+    submission->num_episodes = num_episodes;
+    submission->policy_version = policy_version;
+    submission->arrays = std::move(arrays);
+    SubmittedBatch* batch = submission.get();
+    batch->coordinator = std::thread([batch, collect_fn = std::move(collect_fn)] {
+        try {
+            collect_fn();
+        } catch (...) {
+            batch->error = std::current_exception();
+        }
+        batch->done = true;
+    });
 
-    {
+    const uint64_t handle = next_handle_++;
+    submissions_.emplace(handle, std::move(submission));
+    return handle;
+}
+
+bool BatchedTetrisCollector::poll(uint64_t handle) const {
+    const auto it = submissions_.find(handle);
+    if (it == submissions_.end()) {
+        throw std::invalid_argument("unknown handle, or its batch was already returned by wait()");
+    }
+    return it->second->done;
+}
+
+py::dict BatchedTetrisCollector::wait(uint64_t handle) {
+    const auto it = submissions_.find(handle);
+    if (it == submissions_.end()) {
+        throw std::invalid_argument("unknown handle, or its batch was already returned by wait()");
+    }
+    std::unique_ptr<SubmittedBatch> batch = std::move(it->second);
+    submissions_.erase(it);
+    if (batch->coordinator.joinable()) {
         py::gil_scoped_release release;
-        while (finished.size() < num_episodes) {
-            EpisodeResult result = take_result();
-            finished.push_back(std::move(result));
-        }
+        batch->coordinator.join();
+    }
+    if (!collecting()) {
+        policy_callback_ = py::none();
+    }
+    if (batch->error) {
+        std::rethrow_exception(batch->error);
     }
 
-    policy_callback_ = py::none();
+    batch->arrays["policy_version"] = py::int_(batch->policy_version);
+    return batch->arrays;
+}
+
+bool BatchedTetrisCollector::collecting() const {
+    return std::any_of(submissions_.begin(), submissions_.end(),
+                       [](const auto& submission) { return !submission.second->done; });
+}
+
+py::dict BatchedTetrisCollector::begin_collection(size_t num_episodes, PolicyBatching batching) {
+    if (batching == PolicyBatching::DYNAMIC) {
+        broker_stats_ = BrokerStats{};
+        broker_stats_.batch_sizes.assign(max_batch_size_ + 1, 0);
+        pending_requests_.clear();
+        episodes_left_ = num_episodes;
+        broker_failed_ = false;
+    }
 
+    // Not zeroed: each row is written by its episode, then its padding cleared
     const ssize_t episodes = static_cast<ssize_t>(num_episodes);
     const ssize_t max_steps = static_cast<ssize_t>(max_steps_);
-    const ssize_t obs_dim = static_cast<ssize_t>(obs_dim_);
-
-    py::array_t<float> observations({episodes, max_steps, obs_dim});
+    const ssize_t obs_dim = static_cast<ssize_t>(stored_obs_dim_);
+    py::array observations = observation_array({episodes, max_steps, obs_dim});
     py::array_t<int32_t> actions({episodes, max_steps});
     py::array_t<float> log_probs({episodes, max_steps});
     py::array_t<float> values({episodes, max_steps});
@@ -113,49 +324,19 @@ py::dict BatchedTetrisCollector::request_episodes(size_t num_episodes, py::funct
     py::array_t<uint8_t> dones({episodes, max_steps});
     py::array_t<uint32_t> lengths({episodes});
 
-    zero_fill(observations);
-    zero_fill(actions);
-    zero_fill(log_probs);
-    zero_fill(values);
-    zero_fill(rewards);
-    zero_fill(dones);
-    zero_fill(lengths);
-
-    auto* obs_ptr = observations.mutable_data();
-    auto* act_ptr = actions.mutable_data();
-    auto* log_ptr = log_probs.mutable_data();
-    auto* val_ptr = values.mutable_data();
-    auto* rew_ptr = rewards.mutable_data();
-    auto* done_ptr = dones.mutable_data();
-    auto* len_ptr = lengths.mutable_data();
-
-    const size_t obs_stride = static_cast<size_t>(max_steps_) * obs_dim_;
-    const size_t step_stride = static_cast<size_t>(max_steps_);
-
-    for (size_t ep = 0; ep < finished.size(); ++ep) {
-        const auto& episode = finished[ep];
-        const size_t L = episode.length;
-        len_ptr[ep] = static_cast<uint32_t>(L);
-
-        std::copy(episode.observations.begin(),
-                  episode.observations.end(),
-                  obs_ptr + ep * obs_stride);
-        std::copy(episode.actions.begin(),
-                  episode.actions.end(),
-                  act_ptr + ep * step_stride);
-        std::copy(episode.log_probs.begin(),
-                  episode.log_probs.end(),
-                  log_ptr + ep * step_stride);
-        std::copy(episode.values.begin(),
-                  episode.values.end(),
-                  val_ptr + ep * step_stride);
-        std::copy(episode.rewards.begin(),
-                  episode.rewards.end(),
-                  rew_ptr + ep * step_stride);
-        std::copy(episode.dones.begin(),
-                  episode.dones.end(),
-                  done_ptr + ep * step_stride);
-    }
+    // Episodes start from a reset, and leave the envs with finished games
+    segments_started_ = false;
+    outputs_ = EpisodeOutputs{};
+    outputs_.steps = max_steps_;
+    outputs_.observations = static_cast<uint8_t*>(observations.mutable_data());
+    outputs_.actions = actions.mutable_data();
+    outputs_.log_probs = log_probs.mutable_data();
+    outputs_.values = values.mutable_data();
+    outputs_.rewards = rewards.mutable_data();
+    outputs_.dones = dones.mutable_data();
+    outputs_.lengths = lengths.mutable_data();
+    // Episodes that never ran (close() mid-collection) read as empty
+    std::fill_n(outputs_.lengths, num_episodes, 0u);
 
     py::dict result;
     result["observations"] = std::move(observations);
@@ -168,33 +349,168 @@ py::dict BatchedTetrisCollector::request_episodes(size_t num_episodes, py::funct
     return result;
 }
 
-void BatchedTetrisCollector::worker_loop(size_t worker_idx) {
+py::array BatchedTetrisCollector::observation_array(const std::vector<ssize_t>& shape) const {
+    const bool floats = obs_dtype_ == ObsDtype::FLOAT32;
+    if (huge_pages_) {
+        size_t bytes = floats ? sizeof(float) : 1;
+        for (ssize_t dim : shape) {
+            bytes *= static_cast<size_t>(dim);
+        }
+        // Pages are placed when first written, i.e. by the worker filling that row
+        if (void* data = allocateHugePages(bytes)) {
+            struct Mapping {
+                void* data;
+                size_t bytes;
+            };
+            py::capsule owner(new Mapping{data, bytes}, [](void* ptr) {
+                auto* mapping = static_cast<Mapping*>(ptr);
+                freeHugePages(mapping->data, mapping->bytes);
+                delete mapping;
+            });
+            return floats ? py::array(py::array_t<float>(shape, static_cast<const float*>(data), owner))
+                          : py::array(py::array_t<uint8_t>(shape, static_cast<const uint8_t*>(data), owner));
+        }
+    }
+    return floats ? py::array(py::array_t<float>(shape)) : py::array(py::array_t<uint8_t>(shape));
+}
+
+void BatchedTetrisCollector::collect(size_t num_episodes, PolicyBatching batching) {
+    if (batching == PolicyBatching::LOCKSTEP) {
+        py::gil_scoped_acquire gil;
+        collect_lockstep(num_episodes);
+        return;
+    }
+
+    // Workers read this after popping a job, which the queue orders after here
+    batching_ = batching;
+    std::thread broker;
+    if (batching == PolicyBatching::DYNAMIC) {
+        broker = std::thread(&BatchedTetrisCollector::run_broker, this);
+    }
+
+    // Keep the job queue topped up; whenever it is full some job is still
+    // out, so there is always a result to wait for
+    const uint64_t first_job_id = next_job_id_;
+    next_job_id_ += num_episodes;
+    size_t queued = 0;
+    const auto queue_jobs = [&] {
+        while (queued < num_episodes && job_queue_.tryPush(EpisodeJob{first_job_id + queued, max_steps_, queued})) {
+            ++queued;
+        }
+    };
+    queue_jobs();
+    for (size_t done = 0; done < num_episodes; ++done) {
+        EpisodeResult result;
+        if (!result_queue_.pop(result)) {
+            break;  // closed
+        }
+        queue_jobs();
+    }
+    if (broker.joinable()) {
+        broker.join();
+    }
+    batching_ = PolicyBatching::PER_WORKER;
+
+    if (broker_error_) {
+        std::rethrow_exception(std::exchange(broker_error_, nullptr));
+    }
+}
+
+void BatchedTetrisCollector::init_worker(size_t worker_idx, uint32_t seed, PieceRandomizer randomizer) {
+    if (!worker_cpus_.empty()) {
+        pinCurrentThread(worker_cpus_[worker_idx]);
+    }
+    // Allocated here rather than by the constructing thread, so a pinned
+    // worker's game and scratch rows land on its own NUMA node
+    envs_[worker_idx] = std::make_unique<TetrisGame>(TimeManager::Mode::SIMULATION, queue_size_, seed, randomizer);
+    auto buf = std::make_unique<WorkerBuffers>();
+    // Its own sequence, apart from the piece sequence seeded with `seed`
+    buf->policy_rng = PieceRng(~uint64_t{seed});
+    if (obs_dtype_ != ObsDtype::FLOAT32) {
+        buf->observations.resize(obs_dim_);
+    }
+    if (action_mode_ == ActionMode::PLACEMENT) {
+        // Typical piece counts stay well under this; grows if ever exceeded
+        static constexpr size_t TypicalPlacements = 128;
+        buf->afterstates.reserve(TypicalPlacements * afterstate_dim());
+    }
+    buffers_[worker_idx] = std::move(buf);
+}
+
+void BatchedTetrisCollector::worker_loop(size_t worker_idx, uint32_t seed, PieceRandomizer randomizer) {
+    bool ready = true;
+    try {
+        init_worker(worker_idx, seed, randomizer);
+    } catch (...) {
+        std::lock_guard<std::mutex> lock(init_mutex_);
+        if (!init_error_) {
+            init_error_ = std::current_exception();
+        }
+        ready = false;
+    }
+    {
+        std::lock_guard<std::mutex> lock(init_mutex_);
+        ++workers_ready_;
+    }
+    init_cv_.notify_one();
+    if (!ready) {
+        return;
+    }
+
     auto& env = *envs_[worker_idx];
-    auto& buf = buffers_[worker_idx];
+    auto& buf = *buffers_[worker_idx];
 
     while (true) {
-        EpisodeJob job = take_job();
-        if (shutting_down_) {
+        EpisodeJob job;
+        if (!job_queue_.pop(job) || shutting_down_) {
             return;
         }
 
         env.reset();
         uint32_t step_count = 0;
+        // Weights swapped in by set_policy_weights apply from the next episode
+        const std::shared_ptr<const MlpPolicy> native = use_native_ ? native_policy() : nullptr;
+        PieceRng* policy_rng = &buf.policy_rng;
 
+        const bool float_obs = obs_dtype_ == ObsDtype::FLOAT32;
         while (step_count < job.max_steps) {
-            flatten_observation(env.obs, buf.observations.data() + static_cast<size_t>(step_count) * obs_dim_);
+            // The policy always sees floats: the output row itself, or a scratch row for other dtypes
+            float* policy_obs = float_obs ? float_observation(job.slot, step_count) : buf.observations.data();
+            const size_t num_placements = prepare_step(env, buf, job.slot, step_count, policy_obs);
 
             int action = 0;
             double log_prob = 0.0;
             double value = 0.0;
-            {
+            if (native) {
+                MlpPolicy::Sample sample;
+                native->act(policy_obs, 1, &policy_rng, &sample, buf.mlp);
+                action = sample.action;
+                log_prob = sample.log_prob;
+                value = sample.value;
+            } else if (batching_ == PolicyBatching::DYNAMIC) {
+                float batched_log_prob;
+                float batched_value;
+                if (!request_policy(worker_idx, policy_obs, num_placements, action, batched_log_prob,
+                                    batched_value)) {
+                    break;
+                }
+                log_prob = batched_log_prob;
+                value = batched_value;
+            } else {
                 py::gil_scoped_acquire gil;
                 if (policy_callback_.is_none()) {
                     throw std::runtime_error("Policy callback not set before worker execution.");
                 }
-                py::array_t<float> obs_array({static_cast<ssize_t>(obs_dim_)},
-                                             buf.observations.data() + static_cast<size_t>(step_count) * obs_dim_);
-                py::object out = policy_callback_(obs_array);
+                py::array_t<float> obs_array({static_cast<ssize_t>(obs_dim_)}, policy_obs);
+                py::object out;
+                if (action_mode_ == ActionMode::PLACEMENT) {
+                    py::array_t<float> afterstates(
+                        {static_cast<ssize_t>(num_placements), static_cast<ssize_t>(afterstate_dim())},
+                        buf.afterstates.data());
+                    out = policy_callback_(obs_array, afterstates);
+                } else {
+                    out = policy_callback_(obs_array);
+                }
                 auto tuple = out.cast<py::tuple>();
                 if (tuple.size() != 3) {
                     throw std::runtime_error("policy_fn must return (action, log_prob, value)");
@@ -204,105 +520,500 @@ void BatchedTetrisCollector::worker_loop(size_t worker_idx) {
                 value = tuple[2].cast<double>();
             }
 
-            auto result = env.step(action);
-            buf.actions[step_count] = action;
-            buf.log_probs[step_count] = static_cast<float>(log_prob);
-            buf.values[step_count] = static_cast<float>(value);
-            buf.rewards[step_count] = result.reward;
-            buf.dones[step_count] = result.terminated ? 1 : 0;
-
+            auto result = apply_action(env, job.slot, step_count, action, static_cast<float>(log_prob),
+                                       static_cast<float>(value));
             ++step_count;
             if (result.terminated) {
                 break;
             }
         }
 
-        EpisodeResult episode;
-        episode.job_id = job.job_id;
-        episode.length = step_count;
-        episode.observations.assign(buf.observations.begin(),
-                                    buf.observations.begin() + static_cast<size_t>(step_count) * obs_dim_);
-        episode.actions.assign(buf.actions.begin(), buf.actions.begin() + step_count);
-        episode.log_probs.assign(buf.log_probs.begin(), buf.log_probs.begin() + step_count);
-        episode.values.assign(buf.values.begin(), buf.values.begin() + step_count);
-        episode.rewards.assign(buf.rewards.begin(), buf.rewards.begin() + step_count);
-        episode.dones.assign(buf.dones.begin(), buf.dones.begin() + step_count);
-
-        push_result(std::move(episode));
+        finish_episode(job.slot, step_count);
+        if (batching_ == PolicyBatching::DYNAMIC) {
+            {
+                std::lock_guard<std::mutex> lock(broker_mutex_);
+                if (episodes_left_ > 0) {  // close() zeroes it
+                    --episodes_left_;
+                }
+            }
+            broker_cv_.notify_one();
+        }
+        result_queue_.push(EpisodeResult{job.job_id, job.slot, step_count});
     }
 }
 
-size_t BatchedTetrisCollector::flatten_observation(const Observation& obs, float* dest) const {
-    size_t count = 0;
-    auto write_matrix = [&](const std::vector<std::vector<uint8_t>>& mat) {
-        if (mat.empty()) {
-            return;
+void BatchedTetrisCollector::collect_lockstep(size_t num_episodes) {
+    // One slot per env, playing output row `episode`; when that ends, the
+    // slot starts the next unstarted episode or retires.
+    struct Slot {
+        size_t env;
+        size_t episode;
+        uint32_t step;
+        bool needs_reset;
+    };
+
+    if (!lockstep_pool_) {
+        lockstep_pool_ = std::make_unique<WorkerPool>(envs_.size(), worker_cpus_);
+    }
+
+    if (max_steps_ == 0) {
+        for (size_t i = 0; i < num_episodes; ++i) {
+            finish_episode(i, 0);
         }
-        const size_t rows = mat.size();
-        const size_t cols = mat[0].size();
-        for (size_t r = 0; r < rows; ++r) {
-            for (size_t c = 0; c < cols; ++c) {
-                dest[count++] = static_cast<float>(mat[r][c]);
+        return;
+    }
+
+    std::vector<Slot> active;
+    size_t started = 0;
+    for (; started < std::min(num_episodes, envs_.size()); ++started) {
+        active.push_back(Slot{started, started, 0, true});
+    }
+    std::vector<size_t> envs;
+    std::vector<size_t> num_placements(envs_.size(), 0);
+    std::vector<uint8_t> done(envs_.size(), 0);
+    std::vector<int32_t> actions;
+    std::vector<float> log_probs;
+    std::vector<float> values;
+
+    while (!active.empty()) {
+        const size_t count = active.size();
+        py::array_t<float> obs_batch({static_cast<ssize_t>(count), static_cast<ssize_t>(obs_dim_)});
+        float* obs_rows = obs_batch.mutable_data();
+        {
+            py::gil_scoped_release release;
+            lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    Slot& slot = active[i];
+                    TetrisGame& env = *envs_[slot.env];
+                    if (slot.needs_reset) {
+                        env.reset();
+                        slot.needs_reset = false;
+                    }
+                    num_placements[i] = prepare_step(env, *buffers_[slot.env], slot.episode, slot.step,
+                                                     obs_rows + i * static_cast<size_t>(obs_dim_));
+                }
+            });
+        }
+
+        envs.resize(count);
+        for (size_t i = 0; i < count; ++i) {
+            envs[i] = active[i].env;
+        }
+        call_batched_policy(obs_batch, envs, num_placements, actions, log_probs, values);
+
+        {
+            py::gil_scoped_release release;
+            lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    Slot& slot = active[i];
+                    const StepResult result = apply_action(*envs_[slot.env], slot.episode, slot.step,
+                                                           actions[i], log_probs[i], values[i]);
+                    ++slot.step;
+                    done[i] = result.terminated || slot.step >= max_steps_;
+                    if (done[i]) {
+                        finish_episode(slot.episode, slot.step);
+                    }
+                }
+            });
+        }
+
+        size_t kept = 0;
+        for (size_t i = 0; i < count; ++i) {
+            Slot slot = active[i];
+            if (done[i]) {
+                if (started == num_episodes) {
+                    continue;
+                }
+                slot = Slot{slot.env, started, 0, true};
+                ++started;
             }
+            active[kept++] = slot;
         }
-    };
+        active.resize(kept);
+    }
+}
 
-    write_matrix(obs.active_tetromino);
-    write_matrix(obs.board);
-    write_matrix(obs.holder);
-    write_matrix(obs.queue);
+py::dict BatchedTetrisCollector::begin_segments(uint32_t num_steps) {
+    // Every cell is written, so nothing is zeroed
+    const ssize_t rows = static_cast<ssize_t>(envs_.size());
+    const ssize_t steps = static_cast<ssize_t>(num_steps);
+    const ssize_t obs_dim = static_cast<ssize_t>(stored_obs_dim_);
+    py::array observations = observation_array({rows, steps, obs_dim});
+    py::array next_observations = observation_array({rows, obs_dim});
+    py::array_t<int32_t> actions({rows, steps});
+    py::array_t<float> log_probs({rows, steps});
+    py::array_t<float> values({rows, steps});
+    py::array_t<float> rewards({rows, steps});
+    py::array_t<uint8_t> dones({rows, steps});
+    py::array_t<uint8_t> truncated({rows, steps});
+
+    outputs_ = EpisodeOutputs{};
+    outputs_.steps = num_steps;
+    outputs_.observations = static_cast<uint8_t*>(observations.mutable_data());
+    outputs_.actions = actions.mutable_data();
+    outputs_.log_probs = log_probs.mutable_data();
+    outputs_.values = values.mutable_data();
+    outputs_.rewards = rewards.mutable_data();
+    outputs_.dones = dones.mutable_data();
+    outputs_.truncated = truncated.mutable_data();
+    outputs_.next_observations = static_cast<uint8_t*>(next_observations.mutable_data());
 
-    return count;
+    py::dict result;
+    result["observations"] = std::move(observations);
+    result["actions"] = std::move(actions);
+    result["log_probs"] = std::move(log_probs);
+    result["values"] = std::move(values);
+    result["rewards"] = std::move(rewards);
+    result["dones"] = std::move(dones);
+    result["truncated"] = std::move(truncated);
+    result["next_observations"] = std::move(next_observations);
+    return result;
 }
 
-size_t BatchedTetrisCollector::compute_obs_dim(const Observation& obs) {
-    auto matrix_size = [](const std::vector<std::vector<uint8_t>>& mat) -> size_t {
-        if (mat.empty()) {
-            return 0;
+void BatchedTetrisCollector::collect_segments(uint32_t num_steps) {
+    const size_t count = envs_.size();
+    if (!lockstep_pool_) {
+        lockstep_pool_ = std::make_unique<WorkerPool>(count, worker_cpus_);
+    }
+    if (!segments_started_) {
+        for (auto& env : envs_) {
+            env->reset();
+        }
+        for (auto& buf : buffers_) {
+            buf->segment_length = 0;
+        }
+        segments_started_ = true;
+    }
+
+    const auto finish_step = [&](size_t i, uint32_t step, int action, float log_prob, float value) {
+        TetrisGame& env = *envs_[i];
+        const StepResult result = apply_action(env, i, step, action, log_prob, value);
+        const uint32_t length = ++buffers_[i]->segment_length;
+        const bool truncated = !result.terminated && max_steps_ && length >= max_steps_;
+        outputs_.truncated[i * num_steps + step] = truncated ? 1 : 0;
+        if (result.terminated || truncated) {
+            env.reset();
+            buffers_[i]->segment_length = 0;
         }
-        return static_cast<size_t>(mat.size()) * mat[0].size();
     };
+    // Where the next segment picks up: the value of this row bootstraps the
+    // returns of any episode still running
+    const auto write_next_observations = [&] {
+        const size_t obs_row_bytes = stored_obs_dim_ * (obs_dtype_ == ObsDtype::FLOAT32 ? sizeof(float) : 1);
+        lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                uint8_t* row = outputs_.next_observations + i * obs_row_bytes;
+                if (obs_dtype_ == ObsDtype::FLOAT32) {
+                    write_observation(*envs_[i], reinterpret_cast<float*>(row));
+                } else {
+                    store_observation(*envs_[i], row);
+                }
+            }
+        });
+    };
+
+    if (use_native_) {
+        // No Python at all: each pool thread observes, evaluates and steps
+        // its range of envs, with the range as one batch through the network
+        py::gil_scoped_release release;
+        const std::shared_ptr<const MlpPolicy> policy = native_policy();
+        std::vector<float> obs_rows(count * obs_dim_);
+        std::vector<PieceRng*> rngs(count);
+        for (size_t i = 0; i < count; ++i) {
+            rngs[i] = &buffers_[i]->policy_rng;
+        }
+        std::vector<MlpPolicy::Sample> samples(count);
+        for (uint32_t step = 0; step < num_steps; ++step) {
+            lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+                if (begin == end) {
+                    return;
+                }
+                for (size_t i = begin; i < end; ++i) {
+                    prepare_step(*envs_[i], *buffers_[i], i, step, obs_rows.data() + i * obs_dim_);
+                }
+                // The range's first env lends its scratch to the whole range
+                policy->act(obs_rows.data() + begin * obs_dim_, end - begin, rngs.data() + begin,
+                            samples.data() + begin, buffers_[begin]->mlp);
+                for (size_t i = begin; i < end; ++i) {
+                    finish_step(i, step, samples[i].action, samples[i].log_prob, samples[i].value);
+                }
+            });
+        }
+        write_next_observations();
+        return;
+    }
 
-    return matrix_size(obs.active_tetromino) +
-           matrix_size(obs.board) +
-           matrix_size(obs.holder) +
-           matrix_size(obs.queue);
+    std::vector<size_t> envs(count);
+    for (size_t i = 0; i < count; ++i) {
+        envs[i] = i;
+    }
+    std::vector<size_t> num_placements(count, 0);
+    std::vector<int32_t> actions;
+    std::vector<float> log_probs;
+    std::vector<float> values;
+
+    for (uint32_t step = 0; step < num_steps; ++step) {
+        py::array_t<float> obs_batch({static_cast<ssize_t>(count), static_cast<ssize_t>(obs_dim_)});
+        float* obs_rows = obs_batch.mutable_data();
+        {
+            py::gil_scoped_release release;
+            lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    num_placements[i] = prepare_step(*envs_[i], *buffers_[i], i, step,
+                                                     obs_rows + i * static_cast<size_t>(obs_dim_));
+                }
+            });
+        }
+
+        call_batched_policy(obs_batch, envs, num_placements, actions, log_probs, values);
+
+        py::gil_scoped_release release;
+        lockstep_pool_->parallelFor(count, [&](size_t, size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i) {
+                finish_step(i, step, actions[i], log_probs[i], values[i]);
+            }
+        });
+    }
+
+    py::gil_scoped_release release;
+    write_next_observations();
 }
 
-void BatchedTetrisCollector::enqueue_job(EpisodeJob job) {
-    {
-        std::lock_guard<std::mutex> lock(job_mutex_);
-        job_queue_.push(job);
+void BatchedTetrisCollector::run_broker() {
+    std::vector<PolicyRequest> batch;
+    while (true) {
+        {
+            std::unique_lock<std::mutex> lock(broker_mutex_);
+            broker_cv_.wait(lock, [&] { return !pending_requests_.empty() || episodes_left_ == 0; });
+            if (pending_requests_.empty()) {
+                return;
+            }
+            // Once every worker that still has an episode to play is waiting,
+            // holding the batch any longer gains nothing
+            const auto ready = [&] {
+                return pending_requests_.size() >= std::min({max_batch_size_, episodes_left_, envs_.size()});
+            };
+            broker_cv_.wait_until(lock, pending_requests_.front().submitted + std::chrono::microseconds(max_wait_us_),
+                                  ready);
+            const size_t count = std::min(pending_requests_.size(), max_batch_size_);
+            batch.assign(pending_requests_.begin(), pending_requests_.begin() + count);
+            pending_requests_.erase(pending_requests_.begin(), pending_requests_.begin() + count);
+        }
+        serve_batch(batch);
     }
-    job_cv_.notify_one();
 }
 
-EpisodeJob BatchedTetrisCollector::take_job() {
-    std::unique_lock<std::mutex> lock(job_mutex_);
-    job_cv_.wait(lock, [&] { return shutting_down_ || !job_queue_.empty(); });
-    if (shutting_down_ && job_queue_.empty()) {
-        return EpisodeJob{};
+void BatchedTetrisCollector::serve_batch(const std::vector<PolicyRequest>& batch) {
+    const size_t count = batch.size();
+    std::vector<size_t> envs(count);
+    std::vector<size_t> num_placements(count);
+    std::vector<int32_t> actions;
+    std::vector<float> log_probs;
+    std::vector<float> values;
+    bool failed;
+    {
+        std::lock_guard<std::mutex> lock(broker_mutex_);
+        failed = broker_failed_;
+    }
+
+    if (!failed) {
+        py::gil_scoped_acquire gil;
+        // The broker has its own thread: nothing may escape this block
+        try {
+            const auto now = std::chrono::steady_clock::now();
+            py::array_t<float> obs({static_cast<ssize_t>(count), static_cast<ssize_t>(obs_dim_)});
+            float* rows = obs.mutable_data();
+            for (size_t i = 0; i < count; ++i) {
+                const PolicyRequest& request = batch[i];
+                std::memcpy(rows + i * obs_dim_, request.obs, obs_dim_ * sizeof(float));
+                envs[i] = request.worker;
+                num_placements[i] = request.num_placements;
+
+                uint64_t waited = static_cast<uint64_t>(
+                    std::chrono::duration_cast<std::chrono::microseconds>(now - request.submitted).count());
+                size_t bucket = 0;
+                while (waited && bucket + 1 < BrokerStats::LatencyBuckets) {
+                    waited >>= 1;
+                    ++bucket;
+                }
+                broker_stats_.queue_latency_us[bucket]++;
+            }
+            broker_stats_.batch_sizes[count]++;
+
+            call_batched_policy(obs, envs, num_placements, actions, log_probs, values);
+        } catch (...) {
+            failed = true;
+            broker_error_ = std::current_exception();
+        }
+    }
+    if (failed) {
+        std::lock_guard<std::mutex> lock(broker_mutex_);
+        broker_failed_ = true;
+    }
+
+    for (size_t i = 0; i < count; ++i) {
+        PolicyFuture& future = *futures_[batch[i].worker];
+        {
+            std::lock_guard<std::mutex> lock(future.mutex);
+            future.failed = failed;
+            if (!failed) {
+                future.action = actions[i];
+                future.log_prob = log_probs[i];
+                future.value = values[i];
+            }
+            future.ready = true;
+        }
+        future.cv.notify_one();
     }
-    EpisodeJob job = job_queue_.front();
-    job_queue_.pop();
-    return job;
 }
 
-void BatchedTetrisCollector::push_result(EpisodeResult&& result) {
+bool BatchedTetrisCollector::request_policy(size_t worker, const float* obs, size_t num_placements,
+                                            int& action, float& log_prob, float& value) {
     {
-        std::lock_guard<std::mutex> lock(result_mutex_);
-        result_queue_.push(std::move(result));
+        std::lock_guard<std::mutex> lock(broker_mutex_);
+        if (broker_failed_) {
+            return false;
+        }
+        pending_requests_.push_back(PolicyRequest{worker, obs, num_placements, std::chrono::steady_clock::now()});
+    }
+    broker_cv_.notify_one();
+
+    PolicyFuture& future = *futures_[worker];
+    std::unique_lock<std::mutex> lock(future.mutex);
+    future.cv.wait(lock, [&] { return future.ready; });
+    future.ready = false;
+    if (future.failed) {
+        return false;
+    }
+    action = future.action;
+    log_prob = future.log_prob;
+    value = future.value;
+    return true;
+}
+
+void BatchedTetrisCollector::call_batched_policy(const py::array_t<float>& obs, const std::vector<size_t>& envs,
+                                                 const std::vector<size_t>& num_placements,
+                                                 std::vector<int32_t>& actions, std::vector<float>& log_probs,
+                                                 std::vector<float>& values) {
+    const size_t count = envs.size();
+    py::object out;
+    if (action_mode_ == ActionMode::PLACEMENT) {
+        py::list afterstates;
+        for (size_t i = 0; i < count; ++i) {
+            afterstates.append(py::array_t<float>(
+                {static_cast<ssize_t>(num_placements[i]), static_cast<ssize_t>(afterstate_dim())},
+                buffers_[envs[i]]->afterstates.data()));
+        }
+        out = policy_callback_(obs, afterstates);
+    } else {
+        out = policy_callback_(obs);
+    }
+    auto tuple = out.cast<py::tuple>();
+    if (tuple.size() != 3) {
+        throw std::runtime_error("policy_fn must return (actions, log_probs, values)");
     }
-    result_cv_.notify_one();
+    using IntArray = py::array_t<int32_t, py::array::c_style | py::array::forcecast>;
+    using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+    const IntArray action_array = tuple[0].cast<IntArray>();
+    const FloatArray log_prob_array = tuple[1].cast<FloatArray>();
+    const FloatArray value_array = tuple[2].cast<FloatArray>();
+    if (static_cast<size_t>(action_array.size()) != count || static_cast<size_t>(log_prob_array.size()) != count ||
+        static_cast<size_t>(value_array.size()) != count) {
+        throw std::runtime_error("policy_fn must return one action, log_prob and value per observation");
+    }
+    actions.assign(action_array.data(), action_array.data() + count);
+    log_probs.assign(log_prob_array.data(), log_prob_array.data() + count);
+    values.assign(value_array.data(), value_array.data() + count);
 }
 
-EpisodeResult BatchedTetrisCollector::take_result() {
-    std::unique_lock<std::mutex> lock(result_mutex_);
-    result_cv_.wait(lock, [&] { return shutting_down_ || !result_queue_.empty(); });
-    if (shutting_down_ && result_queue_.empty()) {
-        return EpisodeResult{};
+size_t BatchedTetrisCollector::prepare_step(TetrisGame& env, WorkerBuffers& buf, size_t slot, uint32_t step,
+                                            float* policy_obs) const {
+    write_observation(env, policy_obs);
+    if (obs_dtype_ == ObsDtype::FLOAT32) {
+        float* row = float_observation(slot, step);
+        if (row != policy_obs) {
+            std::memcpy(row, policy_obs, obs_dim_ * sizeof(float));
+        }
+    } else {
+        const size_t row = slot * outputs_.steps + step;
+        store_observation(env, outputs_.observations + row * stored_obs_dim_);
     }
-    EpisodeResult result = std::move(result_queue_.front());
-    result_queue_.pop();
+    if (action_mode_ == ActionMode::PLACEMENT) {
+        return write_afterstates(env, buf.afterstates);
+    }
+    return 0;
+}
+
+StepResult BatchedTetrisCollector::apply_action(TetrisGame& env, size_t slot, uint32_t step,
+                                                int action, float log_prob, float value) const {
+    // With no placements (topped out) stepPlacement falls back to a NOOP step
+    const StepResult result = action_mode_ == ActionMode::PLACEMENT
+                                  ? env.stepPlacement(static_cast<size_t>(action))
+                                  : env.step(action);
+    const size_t i = slot * outputs_.steps + step;
+    outputs_.actions[i] = action;
+    outputs_.log_probs[i] = log_prob;
+    outputs_.values[i] = value;
+    outputs_.rewards[i] = result.reward;
+    outputs_.dones[i] = result.terminated ? 1 : 0;
     return result;
 }
+
+void BatchedTetrisCollector::finish_episode(size_t slot, uint32_t length) const {
+    outputs_.lengths[slot] = length;
+    const size_t begin = slot * outputs_.steps + length;
+    const size_t padding = outputs_.steps - length;
+    const size_t obs_row_bytes = stored_obs_dim_ * (obs_dtype_ == ObsDtype::FLOAT32 ? sizeof(float) : 1);
+    std::memset(outputs_.observations + begin * obs_row_bytes, 0, padding * obs_row_bytes);
+    std::fill_n(outputs_.actions + begin, padding, 0);
+    std::fill_n(outputs_.log_probs + begin, padding, 0.0f);
+    std::fill_n(outputs_.values + begin, padding, 0.0f);
+    std::fill_n(outputs_.rewards + begin, padding, 0.0f);
+    std::fill_n(outputs_.dones + begin, padding, 0);
+}
+
+float* BatchedTetrisCollector::float_observation(size_t slot, uint32_t step) const {
+    const size_t row = slot * outputs_.steps + step;
+    return reinterpret_cast<float*>(outputs_.observations) + row * obs_dim_;
+}
+
+size_t BatchedTetrisCollector::write_observation(TetrisGame& env, float* dest) const {
+    if (obs_mode_ == ObsMode::FEATURES) {
+        return env.writeFeatures(dest);
+    }
+    return flatten_observation(env.getObservation(), dest);
+}
+
+void BatchedTetrisCollector::store_observation(TetrisGame& env, uint8_t* dest) const {
+    const Observation& obs = env.getObservation();
+    if (obs_dtype_ == ObsDtype::PACKED) {
+        obs.pack(dest);
+    } else {
+        std::memcpy(dest, obs.data(), obs.size());
+    }
+}
+
+size_t BatchedTetrisCollector::write_afterstates(TetrisGame& env, std::vector<float>& dest) const {
+    const std::vector<Placement>& placements = env.enumeratePlacements(true);
+    dest.resize(placements.size() * afterstate_dim());
+    float* out = dest.data();
+    for (const Placement& placement : placements) {
+        out += TetrisGame::writeAfterstate(placement, out);
+    }
+    return placements.size();
+}
+
+size_t BatchedTetrisCollector::flatten_observation(const Observation& obs, float* dest) const {
+    // The observation buffer is already laid out in flattening order
+    // (active_tetromino, board, holder, queue), so this is one linear pass.
+    const uint8_t* src = obs.data();
+    const size_t count = obs.size();
+    for (size_t i = 0; i < count; ++i) {
+        dest[i] = static_cast<float>(src[i]);
+    }
+    return count;
+}
+
+size_t BatchedTetrisCollector::compute_obs_dim(const Observation& obs) {
+    return obs.size();
+}
@@ -1,70 +1,202 @@
+#include <algorithm>
 #include <cstdint>
+#include <cstring>
 #include <memory>
+#include <random>
+#include <string>
 #include <pybind11/pybind11.h>
 #include <pybind11/numpy.h>
 #include <pybind11/stl.h>
 
 #include "tetrisGame.h"
 #include "batched_collector.h"
+#include "episodeLog.h"
+#include "fixedTetris.h"
+#include "heuristicAgent.h"
+#include "planner.h"
+#include "tetrisVecEnv.h"
 
 namespace py = pybind11;
 
 // helper methods
-// helper method to convert vec2d to numpy
+// helper method to expose an observation plane as a numpy view.
+// The array aliases the env's observation buffer (no copy) and keeps the
+// owning Python object alive; it is read-only and reflects the next step.
 template <typename T>
-py::array_t<T> vec2d_to_numpy(const std::vector<std::vector<T>>& vec) {
-    // first we can convert our vector to an array
-    size_t rows = vec.size();
-    size_t cols = vec[0].size();
-    // flatten to 1d array
-    py::array_t<T> arr({rows, cols});  // Create array with shape
-    auto buf = arr.template mutable_unchecked<2>();    // Get mutable buffer with 2D access
-
-    // Now copy data
-    for (size_t i = 0; i < rows; i++) {
-        for (size_t j = 0; j < cols; j++) {
-            buf(i, j) = vec[i][j];
-        }
-    }
-
+py::array_t<T> grid_to_numpy(const GridView<T>& grid, py::handle owner) {
+    const ssize_t rows = grid.rows;
+    const ssize_t cols = grid.cols;
+    py::array_t<T> arr({rows, cols},
+                       {cols * static_cast<ssize_t>(sizeof(T)), static_cast<ssize_t>(sizeof(T))},
+                       grid.data,
+                       owner);
+    arr.attr("setflags")(py::arg("write") = false);
     return arr;
 }
 
 // helper method to convert obs to dictionary
-py::dict obs_to_dict(const Observation& obs) {
+py::dict obs_to_dict(const Observation& obs, py::handle owner) {
     py::dict d;
-    d["board"] = vec2d_to_numpy(obs.board);
-    d["active_tetromino"] = vec2d_to_numpy(obs.active_tetromino);
-    d["holder"] = vec2d_to_numpy(obs.holder);
-    d["queue"] = vec2d_to_numpy(obs.queue);
+    d["board"] = grid_to_numpy(obs.board, owner);
+    d["active_tetromino"] = grid_to_numpy(obs.active_tetromino, owner);
+    d["holder"] = grid_to_numpy(obs.holder, owner);
+    d["queue"] = grid_to_numpy(obs.queue, owner);
     return d;
 }
 
-PYBIND11_MODULE(tinyrl_tetris, m, py::mod_gil_not_used()) {
-    m.doc() = "TinyRL Tetris Python Bindings";
+// helper method to convert placements to a dict of parallel arrays
+py::dict placements_to_dict(TetrisGame& game, bool with_boards) {
+    const std::vector<Placement>& placements = game.getPlacements();
+    const ssize_t n = static_cast<ssize_t>(placements.size());
+    const ssize_t k = TetrisGame::BoardFeatureCount;
+    py::array_t<int8_t> x(n), y(n);
+    py::array_t<uint8_t> rotation(n), piece_type(n), lines_cleared(n);
+    py::array_t<bool> use_hold(n);
+    py::array_t<float> features({n, k});
+    for (ssize_t i = 0; i < n; i++) {
+        const Placement& p = placements[i];
+        x.mutable_data()[i] = p.x;
+        y.mutable_data()[i] = p.y;
+        rotation.mutable_data()[i] = p.rotation;
+        piece_type.mutable_data()[i] = p.piece_type;
+        lines_cleared.mutable_data()[i] = p.lines_cleared;
+        use_hold.mutable_data()[i] = p.use_hold;
+        TetrisGame::writeBoardFeatures(p.features, features.mutable_data() + i * k);
+    }
+    py::dict d;
+    d["x"] = x;
+    d["y"] = y;
+    d["rotation"] = rotation;
+    d["piece_type"] = piece_type;
+    d["use_hold"] = use_hold;
+    d["lines_cleared"] = lines_cleared;
+    d["features"] = features;
+    if (with_boards) {
+        py::array_t<uint16_t> boards({n, static_cast<ssize_t>(Tetris::BOARD_HEIGHT)});
+        for (ssize_t i = 0; i < n; i++) {
+            std::copy_n(game.getPlacementBoard(i), Tetris::BOARD_HEIGHT,
+                        boards.mutable_data() + i * Tetris::BOARD_HEIGHT);
+        }
+        d["boards"] = boards;
+    }
+    return d;
+}
 
-    // expose TetrisGame class
-    py::class_<TetrisGame>(m, "TetrisEnv")
-        .def(py::init<TimeManager::Mode, uint8_t>(),
-            py::arg("mode"), py::arg("queue_size") = 3)
-        .def("reset", [](TetrisGame& self) {
+// GameState travels through Python as raw bytes
+py::bytes state_to_bytes(const TetrisGame& game) {
+    const GameState state = game.snapshot();
+    return py::bytes(reinterpret_cast<const char*>(&state), sizeof(state));
+}
+
+// Wraps a Python value function for the planner. Called from planner
+// threads with the GIL released, so it takes the GIL for the call.
+TetrisPlanner::ValueFn wrap_value_fn(py::function fn) {
+    return [fn](const float* afterstates, size_t count, float* values) {
+        py::gil_scoped_acquire gil;
+        py::array_t<float> batch({static_cast<ssize_t>(count), static_cast<ssize_t>(TetrisGame::AfterstateSize)});
+        std::copy_n(afterstates, count * TetrisGame::AfterstateSize, batch.mutable_data());
+        auto out = fn(batch).cast<py::array_t<float, py::array::c_style | py::array::forcecast>>();
+        if (static_cast<size_t>(out.size()) != count) {
+            throw py::value_error("value_fn must return one value per afterstate row");
+        }
+        std::copy_n(out.data(), count, values);
+    };
+}
+
+using FloatArray = py::array_t<float, py::array::c_style | py::array::forcecast>;
+
+// One torch.nn.Linear as numpy arrays: weight [outputs, inputs], bias [outputs]
+MlpPolicy::Layer linear_layer(const FloatArray& weight, const FloatArray& bias) {
+    if (weight.ndim() != 2 || bias.ndim() != 1 || bias.shape(0) != weight.shape(0)) {
+        throw py::value_error("each layer needs a [outputs, inputs] weight and an [outputs] bias");
+    }
+    MlpPolicy::Layer layer;
+    layer.outputs = static_cast<size_t>(weight.shape(0));
+    layer.inputs = static_cast<size_t>(weight.shape(1));
+    layer.weights.assign(weight.data(), weight.data() + weight.size());
+    layer.bias.assign(bias.data(), bias.data() + bias.size());
+    return layer;
+}
+
+// Observation of a FixedTetris as a dict like TetrisEnv's, viewing one
+// freshly rendered buffer (the planes are W columns wide, no padding)
+template <typename Game>
+py::dict fixed_obs_to_dict(const Game& game) {
+    constexpr int board_cells = Game::Rows * Game::Width;
+    py::array_t<uint8_t> flat(static_cast<ssize_t>(Game::ObsSize));
+    uint8_t* data = flat.mutable_data();
+    game.writeObservation(data);
+    py::dict d;
+    d["active_tetromino"] = grid_to_numpy(GridView<uint8_t>{data, Game::Rows, Game::Width}, flat);
+    d["board"] = grid_to_numpy(GridView<uint8_t>{data + board_cells, Game::Rows, Game::Width}, flat);
+    d["holder"] = grid_to_numpy(
+        GridView<uint8_t>{data + 2 * board_cells, Tetris::PIECE_SIZE, Tetris::PIECE_SIZE}, flat);
+    d["queue"] = grid_to_numpy(GridView<uint8_t>{data + 2 * board_cells + Game::PieceCells,
+                                                 Game::QueueSize * Tetris::PIECE_SIZE, Tetris::PIECE_SIZE},
+                               flat);
+    return d;
+}
+
+// One compiled board size as a Python env with TetrisEnv's reset/step
+template <typename Game>
+void bind_fixed_env(py::module_& m, const char* name) {
+    py::class_<Game> cls(m, name);
+    cls.def(py::init([](py::object seed, PieceRandomizer randomizer) {
+            const uint32_t s = seed.is_none() ? std::random_device{}() : seed.cast<uint32_t>();
+            return std::make_unique<Game>(s, randomizer);
+        }), py::arg("seed") = py::none(), py::arg("randomizer") = PieceRandomizer::UNIFORM)
+        .def("reset", [](Game& self) {
             self.reset();
-            return obs_to_dict(self.obs);
+            return fixed_obs_to_dict(self);
         })
-        .def("step", [](TetrisGame& self, int action) {
-            StepResult result = self.step(action);
-            return py::make_tuple(
-                obs_to_dict(result.obs),
-                result.reward,
-                result.terminated,
-                py::dict()  // empty info dict
-            );
+        .def("step", [](Game& self, int action) {
+            const StepResult result = self.step(action);
+            return py::make_tuple(fixed_obs_to_dict(self), result.reward, result.terminated, py::dict());
         })
-        .def_property_readonly("obs", [](TetrisGame& self) {
-            return obs_to_dict(self.obs);
-        })
-        .def_readonly("score", &TetrisGame::score)
-        .def_readonly("game_over", &TetrisGame::game_over);
+        .def_property_readonly("obs", [](const Game& self) { return fixed_obs_to_dict(self); })
+        .def_property_readonly("ghost_y", &Game::getGhostY)
+        .def_property_readonly("randomizer", [](const Game& self) { return self.pieces.randomizer; })
+        .def_readonly("score", &Game::score)
+        .def_readonly("game_over", &Game::game_over);
+    cls.attr("width") = py::int_(Game::Width);
+    cls.attr("height") = py::int_(Game::Height);
+    cls.attr("queue_size") = py::int_(Game::QueueSize);
+    cls.attr("obs_size") = py::int_(Game::ObsSize);
+}
+
+// Read-only numpy view of an engine-owned buffer, kept alive by owner
+template <typename T>
+py::array_t<T> buffer_view(const T* data, std::vector<ssize_t> shape, py::handle owner) {
+    py::array_t<T> arr(shape, data, owner);
+    arr.attr("setflags")(py::arg("write") = false);
+    return arr;
+}
+
+// The vec env's [num_envs, stored_obs_dim] observation rows
+py::array vec_obs_view(const TetrisVecEnv& env, bool final_rows, py::handle owner) {
+    const std::vector<ssize_t> shape = {static_cast<ssize_t>(env.size()), static_cast<ssize_t>(env.storedObsDim())};
+    if (env.obsDtype() == ObsDtype::FLOAT32) {
+        return buffer_view(final_rows ? env.finalObservations() : env.observations(), shape, owner);
+    }
+    return buffer_view(final_rows ? env.finalObservationBytes() : env.observationBytes(), shape, owner);
+}
+
+py::array_t<bool> flags_view(const TetrisVecEnv& env, const uint8_t* flags, py::handle owner) {
+    return buffer_view(reinterpret_cast<const bool*>(flags), {static_cast<ssize_t>(env.size())}, owner);
+}
+
+GameState bytes_to_state(const py::bytes& data) {
+    const std::string raw = data;
+    if (raw.size() != sizeof(GameState)) {
+        throw py::value_error("not a TetrisEnv snapshot");
+    }
+    GameState state;
+    std::memcpy(&state, raw.data(), sizeof(state));
+    return state;
+}
+
+PYBIND11_MODULE(tinyrl_tetris, m, py::mod_gil_not_used()) {
+    m.doc() = "TinyRL Tetris Python Bindings";
 
     // Expose enums
     py::enum_<Action>(m, "Action")
@@ -78,22 +210,424 @@ PYBIND11_MODULE(tinyrl_tetris, m, py::mod_gil_not_used()) {
         .value("NOOP", Action::NOOP)
         .export_values();
 
+    py::enum_<ObsMode>(m, "ObsMode")
+        .value("BOARD", ObsMode::BOARD)
+        .value("FEATURES", ObsMode::FEATURES);
+
+    py::enum_<ObsDtype>(m, "ObsDtype")
+        .value("FLOAT32", ObsDtype::FLOAT32)
+        .value("UINT8", ObsDtype::UINT8)
+        .value("PACKED", ObsDtype::PACKED);
+
+    py::enum_<ActionMode>(m, "ActionMode")
+        .value("PRIMITIVE", ActionMode::PRIMITIVE)
+        .value("PLACEMENT", ActionMode::PLACEMENT);
+
+    py::enum_<PolicyBatching>(m, "PolicyBatching")
+        .value("PER_WORKER", PolicyBatching::PER_WORKER)
+        .value("LOCKSTEP", PolicyBatching::LOCKSTEP)
+        .value("DYNAMIC", PolicyBatching::DYNAMIC);
+
+    py::enum_<PieceRandomizer>(m, "PieceRandomizer")
+        .value("UNIFORM", PieceRandomizer::UNIFORM)
+        .value("BAG7", PieceRandomizer::BAG7)
+        .value("COMPAT", PieceRandomizer::COMPAT);
+
     py::enum_<TimeManager::Mode>(m, "TimeMode")
         .value("REALTIME", TimeManager::Mode::REALTIME)
         .value("STEPPED", TimeManager::Mode::SIMULATION)
         .export_values();
 
+    // expose TetrisGame class
+    py::class_<TetrisGame>(m, "TetrisEnv")
+        .def(py::init([](TimeManager::Mode mode, uint8_t queue_size, py::object seed, PieceRandomizer randomizer) {
+            const uint32_t s = seed.is_none() ? std::random_device{}() : seed.cast<uint32_t>();
+            return std::make_unique<TetrisGame>(mode, queue_size, s, randomizer);
+        }), py::arg("mode"), py::arg("queue_size") = 3, py::arg("seed") = py::none(),
+            py::arg("randomizer") = PieceRandomizer::UNIFORM)
+        .def("reset", [](py::object owner) {
+            TetrisGame& self = owner.cast<TetrisGame&>();
+            self.reset();
+            return obs_to_dict(self.getObservation(), owner);
+        })
+        .def("step", [](py::object owner, int action) {
+            TetrisGame& self = owner.cast<TetrisGame&>();
+            StepResult result = self.step(action);
+            return py::make_tuple(
+                obs_to_dict(self.getObservation(), owner),
+                result.reward,
+                result.terminated,
+                py::dict()  // empty info dict
+            );
+        })
+        .def("snapshot", &state_to_bytes)
+        .def("restore", [](TetrisGame& self, const py::bytes& data) {
+            if (!self.restore(bytes_to_state(data))) {
+                throw py::value_error("snapshot was taken with a different queue_size");
+            }
+        }, py::arg("state"))
+        .def(py::pickle(
+            [](const TetrisGame& self) {
+                return py::make_tuple(self.tm.getMode(), self.queue_size, state_to_bytes(self));
+            },
+            [](const py::tuple& t) {
+                if (t.size() != 3) {
+                    throw std::runtime_error("invalid TetrisEnv pickle");
+                }
+                auto game = std::make_unique<TetrisGame>(t[0].cast<TimeManager::Mode>(), t[1].cast<uint8_t>(), 0);
+                game->restore(bytes_to_state(t[2].cast<py::bytes>()));
+                return game;
+            }))
+        .def("placements", [](TetrisGame& self, bool include_hold, bool with_boards) {
+            self.enumeratePlacements(include_hold, with_boards);
+            return placements_to_dict(self, with_boards);
+        }, py::arg("include_hold") = false, py::arg("with_boards") = false)
+        .def("step_placement", [](py::object owner, size_t index) {
+            TetrisGame& self = owner.cast<TetrisGame&>();
+            if (index >= self.getPlacements().size()) {
+                throw py::index_error("placement index out of range; call placements() first");
+            }
+            StepResult result = self.stepPlacement(index);
+            return py::make_tuple(
+                obs_to_dict(self.getObservation(), owner),
+                result.reward,
+                result.terminated,
+                py::dict()
+            );
+        }, py::arg("index"))
+        .def_property_readonly("obs", [](py::object owner) {
+            TetrisGame& self = owner.cast<TetrisGame&>();
+            return obs_to_dict(self.getObservation(), owner);
+        })
+        .def_property_readonly("features", [](TetrisGame& self) {
+            py::array_t<float> arr(static_cast<ssize_t>(self.featureSize()));
+            self.writeFeatures(arr.mutable_data());
+            return arr;
+        })
+        .def_property_readonly("feature_dim", [](const TetrisGame& self) { return self.featureSize(); })
+        .def_property_readonly("ghost_y", &TetrisGame::getGhostY)
+        .def_property_readonly("randomizer", [](const TetrisGame& self) { return self.pieces.randomizer; })
+        .def_readonly("score", &TetrisGame::score)
+        .def_readonly("game_over", &TetrisGame::game_over);
+
+    // Compiled board sizes: standard, mini (curriculum) and tall
+    bind_fixed_env<Tetris10x20>(m, "TetrisEnv10x20");
+    bind_fixed_env<Tetris6x12>(m, "TetrisEnv6x12");
+    bind_fixed_env<Tetris10x40>(m, "TetrisEnv10x40");
+
+    // N envs per call. Outputs are views of buffers the env reuses, so
+    // they change on the next step/reset; copy what you keep.
+    py::class_<TetrisVecEnv>(m, "TetrisVecEnv")
+        .def(py::init([](size_t num_envs, uint8_t queue_size, py::object seed, PieceRandomizer randomizer,
+                         size_t num_threads, uint32_t max_episode_steps, ObsDtype obs_dtype) {
+            const uint32_t s = seed.is_none() ? std::random_device{}() : seed.cast<uint32_t>();
+            return std::make_unique<TetrisVecEnv>(num_envs, queue_size, s, randomizer, num_threads,
+                                                  max_episode_steps, obs_dtype);
+        }), py::arg("num_envs"), py::arg("queue_size") = 3, py::arg("seed") = py::none(),
+            py::arg("randomizer") = PieceRandomizer::UNIFORM, py::arg("num_threads") = 1,
+            py::arg("max_episode_steps") = 0, py::arg("obs_dtype") = ObsDtype::FLOAT32)
+        // seeds: None continues each env's piece sequence, an int seeds env i
+        // with seeds + i, or one seed per env
+        .def("reset", [](py::object owner, py::object seeds) {
+            TetrisVecEnv& self = owner.cast<TetrisVecEnv&>();
+            std::vector<uint32_t> per_env;
+            if (py::isinstance<py::int_>(seeds)) {
+                const uint32_t base = seeds.cast<uint32_t>();
+                for (size_t i = 0; i < self.size(); i++) {
+                    per_env.push_back(base + static_cast<uint32_t>(i));
+                }
+            } else if (!seeds.is_none()) {
+                per_env = seeds.cast<std::vector<uint32_t>>();
+                if (per_env.size() != self.size()) {
+                    throw py::value_error("need one seed per env");
+                }
+            }
+            {
+                py::gil_scoped_release release;
+                self.reset(per_env.empty() ? nullptr : per_env.data());
+            }
+            return vec_obs_view(self, false, owner);
+        }, py::arg("seeds") = py::none())
+        .def("step", [](py::object owner, py::array_t<int32_t, py::array::c_style | py::array::forcecast> actions) {
+            TetrisVecEnv& self = owner.cast<TetrisVecEnv&>();
+            if (static_cast<size_t>(actions.size()) != self.size()) {
+                throw py::value_error("need one action per env");
+            }
+            {
+                py::gil_scoped_release release;
+                self.step(actions.data());
+            }
+            return py::make_tuple(
+                vec_obs_view(self, false, owner),
+                buffer_view(self.rewards(), {static_cast<ssize_t>(self.size())}, owner),
+                flags_view(self, self.terminated(), owner),
+                flags_view(self, self.truncated(), owner));
+        }, py::arg("actions"))
+        .def_property_readonly("obs", [](py::object owner) {
+            return vec_obs_view(owner.cast<const TetrisVecEnv&>(), false, owner);
+        })
+        // Where the latest step ended an episode: its last observation, score and length
+        .def_property_readonly("final_obs", [](py::object owner) {
+            return vec_obs_view(owner.cast<const TetrisVecEnv&>(), true, owner);
+        })
+        .def_property_readonly("final_scores", [](py::object owner) {
+            const TetrisVecEnv& self = owner.cast<const TetrisVecEnv&>();
+            return buffer_view(self.finalScores(), {static_cast<ssize_t>(self.size())}, owner);
+        })
+        .def_property_readonly("final_lengths", [](py::object owner) {
+            const TetrisVecEnv& self = owner.cast<const TetrisVecEnv&>();
+            return buffer_view(self.finalLengths(), {static_cast<ssize_t>(self.size())}, owner);
+        })
+        .def_property_readonly("num_envs", &TetrisVecEnv::size)
+        .def_property_readonly("queue_size", &TetrisVecEnv::queueSize)
+        .def_property_readonly("obs_dim", &TetrisVecEnv::obsDim)
+        .def_property_readonly("stored_obs_dim", &TetrisVecEnv::storedObsDim)
+        .def_property_readonly("obs_dtype", &TetrisVecEnv::obsDtype)
+        .def_property_readonly("num_threads", &TetrisVecEnv::numThreads)
+        .def_property_readonly("max_episode_steps", &TetrisVecEnv::maxEpisodeSteps);
+
     py::class_<BatchedTetrisCollector>(m, "BatchedTetrisCollector")
-        .def(py::init<size_t, uint32_t, uint8_t, uint32_t>(),
+        .def(py::init<size_t, uint32_t, uint8_t, uint32_t, ObsMode, ActionMode, PieceRandomizer, ObsDtype, bool,
+                      bool>(),
              py::arg("num_workers"),
              py::arg("max_steps"),
              py::arg("queue_size") = 3,
-             py::arg("seed_base") = 0)
+             py::arg("seed_base") = 0,
+             py::arg("obs_mode") = ObsMode::BOARD,
+             py::arg("action_mode") = ActionMode::PRIMITIVE,
+             py::arg("randomizer") = PieceRandomizer::UNIFORM,
+             py::arg("obs_dtype") = ObsDtype::FLOAT32,
+             py::arg("pin_workers") = false,
+             py::arg("huge_pages") = false)
         .def("request_episodes", &BatchedTetrisCollector::request_episodes,
              py::arg("num_episodes"),
+             py::arg("policy_fn"),
+             py::arg("batching") = PolicyBatching::PER_WORKER)
+        .def("submit", &BatchedTetrisCollector::submit,
+             py::arg("num_episodes"),
+             py::arg("policy_fn"),
+             py::arg("batching") = PolicyBatching::PER_WORKER,
+             py::arg("policy_version") = 0)
+        .def("request_segments", &BatchedTetrisCollector::request_segments,
+             py::arg("num_steps"),
              py::arg("policy_fn"))
+        .def("submit_segments", &BatchedTetrisCollector::submit_segments,
+             py::arg("num_steps"),
+             py::arg("policy_fn"),
+             py::arg("policy_version") = 0)
+        // Copies the actor-critic in for policy_fn=None; safe between
+        // collections and while a submitted one is running
+        .def("set_policy_weights", [](BatchedTetrisCollector& self, const std::vector<FloatArray>& hidden_weights,
+                                      const std::vector<FloatArray>& hidden_biases, const FloatArray& actor_weight,
+                                      const FloatArray& actor_bias, const FloatArray& critic_weight,
+                                      const FloatArray& critic_bias) {
+            if (hidden_weights.size() != hidden_biases.size()) {
+                throw py::value_error("need one bias per hidden weight");
+            }
+            std::vector<MlpPolicy::Layer> hidden;
+            for (size_t i = 0; i < hidden_weights.size(); i++) {
+                hidden.push_back(linear_layer(hidden_weights[i], hidden_biases[i]));
+            }
+            self.set_policy_weights(std::make_shared<const MlpPolicy>(
+                std::move(hidden), linear_layer(actor_weight, actor_bias), linear_layer(critic_weight, critic_bias)));
+        }, py::arg("hidden_weights"), py::arg("hidden_biases"), py::arg("actor_weight"), py::arg("actor_bias"),
+           py::arg("critic_weight"), py::arg("critic_bias"))
+        .def("clear_policy_weights", [](BatchedTetrisCollector& self) { self.set_policy_weights(nullptr); })
+        .def_property_readonly("has_policy_weights", [](const BatchedTetrisCollector& self) {
+            return static_cast<bool>(self.native_policy());
+        })
+        .def("poll", &BatchedTetrisCollector::poll, py::arg("handle"))
+        .def("wait", &BatchedTetrisCollector::wait, py::arg("handle"))
         .def("close", &BatchedTetrisCollector::close)
+        .def_property_readonly("num_envs", &BatchedTetrisCollector::num_envs)
         .def_property_readonly("obs_dim", &BatchedTetrisCollector::obs_dim)
-        .def_property_readonly("max_steps", &BatchedTetrisCollector::max_steps);
+        .def_property_readonly("max_steps", &BatchedTetrisCollector::max_steps)
+        .def_property_readonly("obs_mode", &BatchedTetrisCollector::obs_mode)
+        .def_property_readonly("action_mode", &BatchedTetrisCollector::action_mode)
+        .def_property_readonly("obs_dtype", &BatchedTetrisCollector::obs_dtype)
+        .def_property_readonly("stored_obs_dim", &BatchedTetrisCollector::stored_obs_dim)
+        .def_property_readonly("pin_workers", &BatchedTetrisCollector::pin_workers)
+        .def_property_readonly("huge_pages", &BatchedTetrisCollector::huge_pages)
+        .def_property("max_batch_size", &BatchedTetrisCollector::max_batch_size,
+                      &BatchedTetrisCollector::set_max_batch_size)
+        .def_property("max_wait_us", &BatchedTetrisCollector::max_wait_us, &BatchedTetrisCollector::set_max_wait_us)
+        // Histograms from the last DYNAMIC request: batch_sizes[n] policy
+        // calls had n rows; queue_latency_us[b] requests waited under 2^b us
+        .def("broker_stats", [](const BatchedTetrisCollector& self) {
+            const BrokerStats& stats = self.broker_stats();
+            py::array_t<uint64_t> batch_sizes(static_cast<ssize_t>(stats.batch_sizes.size()));
+            std::copy(stats.batch_sizes.begin(), stats.batch_sizes.end(), batch_sizes.mutable_data());
+            py::array_t<uint64_t> latency(static_cast<ssize_t>(stats.queue_latency_us.size()));
+            std::copy(stats.queue_latency_us.begin(), stats.queue_latency_us.end(), latency.mutable_data());
+            py::dict result;
+            result["batch_sizes"] = batch_sizes;
+            result["queue_latency_us"] = latency;
+            return result;
+        })
+        .def_property_readonly("afterstate_dim", [](const BatchedTetrisCollector&) {
+            return BatchedTetrisCollector::afterstate_dim();
+        });
+
+    // Expands ObsDtype.PACKED observations (any leading shape, packed rows
+    // last) to float32 cells, e.g. one minibatch at a time
+    m.def("unpack_observations", [](py::array_t<uint8_t, py::array::c_style | py::array::forcecast> packed,
+                                    int queue_size) {
+        if (queue_size < 1) {
+            throw py::value_error("queue_size must be positive");
+        }
+        const size_t row = Observation::packedSize(queue_size);
+        if (packed.ndim() == 0 || static_cast<size_t>(packed.shape(packed.ndim() - 1)) != row) {
+            throw py::value_error("last dimension must be the packed row size, " + std::to_string(row));
+        }
+        const size_t count = static_cast<size_t>(packed.size()) / row;
+        std::vector<ssize_t> shape(packed.shape(), packed.shape() + packed.ndim());
+        shape.back() = static_cast<ssize_t>(Observation(queue_size).size());
+        py::array_t<float> out(shape);
+        const uint8_t* src = packed.data();
+        float* dest = out.mutable_data();
+        {
+            py::gil_scoped_release release;
+            Observation::unpack(src, count, queue_size, dest);
+        }
+        return out;
+    }, py::arg("packed"), py::arg("queue_size") = 3);
+
+    py::class_<PlannerConfig> planner_config(m, "PlannerConfig");
+    py::enum_<PlannerConfig::Algorithm>(planner_config, "Algorithm")
+        .value("BEAM", PlannerConfig::BEAM)
+        .value("MCTS", PlannerConfig::MCTS);
+    planner_config
+        .def(py::init<>())
+        .def_readwrite("algorithm", &PlannerConfig::algorithm)
+        .def_readwrite("num_threads", &PlannerConfig::num_threads)
+        .def_readwrite("depth", &PlannerConfig::depth)
+        .def_readwrite("use_hold", &PlannerConfig::use_hold)
+        .def_readwrite("discount", &PlannerConfig::discount)
+        .def_readwrite("terminal_value", &PlannerConfig::terminal_value)
+        .def_readwrite("seed", &PlannerConfig::seed)
+        .def_readwrite("beam_width", &PlannerConfig::beam_width)
+        .def_readwrite("simulations", &PlannerConfig::simulations)
+        .def_readwrite("exploration", &PlannerConfig::exploration);
+
+    py::class_<TetrisPlanner>(m, "TetrisPlanner")
+        .def(py::init<const PlannerConfig&, uint8_t>(),
+             py::arg("config") = PlannerConfig(),
+             py::arg("queue_size") = 3)
+        .def("set_value_fn", [](TetrisPlanner& self, py::object fn) {
+            self.setValueFn(fn.is_none() ? TetrisPlanner::ValueFn() : wrap_value_fn(fn.cast<py::function>()));
+        }, py::arg("value_fn"))
+        .def("plan", [](TetrisPlanner& self, TetrisGame& env) {
+            const GameState root = env.snapshot();
+            PlanResult result;
+            {
+                py::gil_scoped_release release;
+                result = self.plan(root);
+            }
+            // The returned index refers to this enumeration, ready for env.step_placement
+            env.enumeratePlacements(self.config().use_hold);
+
+            py::array_t<float> root_scores(static_cast<ssize_t>(result.root_scores.size()));
+            std::copy(result.root_scores.begin(), result.root_scores.end(), root_scores.mutable_data());
+            py::dict d;
+            d["placement"] = result.placement;
+            d["value"] = result.value;
+            d["pieces_simulated"] = result.pieces_simulated;
+            d["root_scores"] = root_scores;
+            return d;
+        }, py::arg("env"))
+        .def_property_readonly("config", &TetrisPlanner::config);
+
+    py::class_<EpisodeRecorder>(m, "EpisodeRecorder")
+        .def(py::init<const TetrisGame&, ActionMode, bool, uint16_t>(),
+             py::arg("env"),
+             py::arg("action_mode") = ActionMode::PRIMITIVE,
+             py::arg("include_hold") = false,
+             py::arg("checksum_interval") = 1)
+        .def(py::init<uint32_t, uint8_t, ActionMode, bool, uint16_t, PieceRandomizer>(),
+             py::arg("seed"),
+             py::arg("queue_size") = 3,
+             py::arg("action_mode") = ActionMode::PRIMITIVE,
+             py::arg("include_hold") = false,
+             py::arg("checksum_interval") = 1,
+             py::arg("randomizer") = PieceRandomizer::UNIFORM)
+        .def("record", &EpisodeRecorder::record, py::arg("action"), py::arg("env"))
+        .def("clear", &EpisodeRecorder::clear)
+        .def("to_bytes", [](const EpisodeRecorder& self) {
+            const std::vector<uint8_t> data = self.serialize();
+            return py::bytes(reinterpret_cast<const char*>(data.data()), data.size());
+        })
+        .def_property_readonly("num_steps", &EpisodeRecorder::numSteps);
+
+    py::class_<EpisodeReplayer>(m, "EpisodeReplayer")
+        .def(py::init([](const py::bytes& data) {
+            const std::string raw = data;
+            return std::make_unique<EpisodeReplayer>(reinterpret_cast<const uint8_t*>(raw.data()), raw.size());
+        }), py::arg("data"))
+        .def("rewind", &EpisodeReplayer::rewind)
+        .def("step", &EpisodeReplayer::step)
+        .def("seek", [](EpisodeReplayer& self, size_t steps) {
+            if (!self.seek(steps)) {
+                throw py::index_error("seek past the end of the episode");
+            }
+        }, py::arg("steps"))
+        .def("verify", &EpisodeReplayer::verify)
+        // Row t is the observation before action start + t, as the collector stores it
+        .def("observations", [](EpisodeReplayer& self, size_t start, py::object stop_arg, ObsMode obs_mode) {
+            const size_t stop = stop_arg.is_none() ? self.numSteps() : stop_arg.cast<size_t>();
+            if (start > stop || stop > self.numSteps()) {
+                throw py::index_error("observation range out of bounds");
+            }
+            const ssize_t n = static_cast<ssize_t>(stop - start);
+            self.seek(start);
+            TetrisGame& game = self.game();
+            if (obs_mode == ObsMode::FEATURES) {
+                const ssize_t dim = static_cast<ssize_t>(game.featureSize());
+                py::array_t<float> out({n, dim});
+                for (ssize_t t = 0; t < n; t++, self.step()) {
+                    game.writeFeatures(out.mutable_data() + t * dim);
+                }
+                return py::array(out);
+            }
+            const ssize_t dim = static_cast<ssize_t>(game.getObservation().size());
+            py::array_t<uint8_t> out({n, dim});
+            for (ssize_t t = 0; t < n; t++, self.step()) {
+                std::memcpy(out.mutable_data() + t * dim, game.getObservation().data(), dim);
+            }
+            return py::array(out);
+        }, py::arg("start") = 0, py::arg("stop") = py::none(), py::arg("obs_mode") = ObsMode::BOARD)
+        .def_property_readonly("env", &EpisodeReplayer::game, py::return_value_policy::reference_internal)
+        .def_property_readonly("actions", [](const EpisodeReplayer& self) {
+            py::array_t<int32_t> out(static_cast<ssize_t>(self.numSteps()));
+            std::copy(self.actions().begin(), self.actions().end(), out.mutable_data());
+            return out;
+        })
+        .def_property_readonly("num_steps", &EpisodeReplayer::numSteps)
+        .def_property_readonly("position", &EpisodeReplayer::position)
+        .def_property_readonly("seed", [](const EpisodeReplayer& self) { return self.header().seed; })
+        .def_property_readonly("randomizer", [](const EpisodeReplayer& self) { return self.header().randomizer; })
+        .def_property_readonly("queue_size", [](const EpisodeReplayer& self) { return self.header().queue_size; })
+        .def_property_readonly("action_mode", [](const EpisodeReplayer& self) { return self.header().action_mode; })
+        .def_property_readonly("final_score", [](const EpisodeReplayer& self) { return self.header().final_score; });
+
+    py::class_<HeuristicAgent>(m, "HeuristicAgent")
+        .def(py::init([](bool use_hold) {
+            return std::make_unique<HeuristicAgent>(LinearValue::elTetris(), HeuristicAgent::ElTetrisLandingHeight,
+                                                    use_hold);
+        }), py::arg("use_hold") = false)
+        // Leaves env's placements enumerated, so env.step_placement(index) plays it
+        .def("choose", &HeuristicAgent::choose, py::arg("env"))
+        .def("play", [](HeuristicAgent& self, TetrisGame& env, uint32_t max_pieces) {
+            HeuristicAgent::GameStats stats;
+            {
+                py::gil_scoped_release release;
+                stats = self.play(env, max_pieces);
+            }
+            py::dict d;
+            d["pieces"] = stats.pieces;
+            d["lines"] = stats.lines;
+            d["topped_out"] = stats.topped_out;
+            return d;
+        }, py::arg("env"), py::arg("max_pieces") = 100000)
+        .def_property_readonly("use_hold", &HeuristicAgent::use_hold);
 
 }
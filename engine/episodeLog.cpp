@@ -0,0 +1,288 @@
+#include "episodeLog.h"
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+void putU16(std::vector<uint8_t>& out, uint16_t v) {
+    out.push_back(static_cast<uint8_t>(v));
+    out.push_back(static_cast<uint8_t>(v >> 8));
+}
+
+void putU32(std::vector<uint8_t>& out, uint32_t v) {
+    for (int i = 0; i < 4; i++) {
+        out.push_back(static_cast<uint8_t>(v >> (8 * i)));
+    }
+}
+
+void putVarint(std::vector<uint8_t>& out, uint64_t v) {
+    while (v >= 0x80) {
+        out.push_back(static_cast<uint8_t>(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back(static_cast<uint8_t>(v));
+}
+
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t size) : data_(data), end_(data + size) {}
+
+    size_t remaining() const { return static_cast<size_t>(end_ - data_); }
+
+    const uint8_t* take(size_t n) {
+        if (remaining() < n) {
+            throw std::invalid_argument("episode log is truncated");
+        }
+        const uint8_t* p = data_;
+        data_ += n;
+        return p;
+    }
+    uint8_t u8() { return *take(1); }
+    uint16_t u16() {
+        const uint8_t* p = take(2);
+        return static_cast<uint16_t>(p[0] | (p[1] << 8));
+    }
+    uint32_t u32() {
+        const uint8_t* p = take(4);
+        return static_cast<uint32_t>(p[0]) | (static_cast<uint32_t>(p[1]) << 8) |
+               (static_cast<uint32_t>(p[2]) << 16) | (static_cast<uint32_t>(p[3]) << 24);
+    }
+    uint64_t varint() {
+        uint64_t v = 0;
+        for (int shift = 0; shift < 64; shift += 7) {
+            const uint8_t byte = u8();
+            v |= static_cast<uint64_t>(byte & 0x7F) << shift;
+            if (!(byte & 0x80)) {
+                return v;
+            }
+        }
+        throw std::invalid_argument("episode log has a malformed varint");
+    }
+
+private:
+    const uint8_t* data_;
+    const uint8_t* end_;
+};
+
+uint64_t mix(uint64_t h, uint64_t v) {
+    h ^= v + 0x9e3779b97f4a7c15ULL + (h << 6) + (h >> 2);
+    return h * 0xff51afd7ed558ccdULL;
+}
+
+}  // namespace
+
+uint32_t EpisodeLog::checksum(const TetrisGame& game) {
+    const GameState s = game.snapshot();
+    uint64_t h = 0;
+    // Field by field: the struct's padding bytes are unspecified
+    for (int y = 0; y < Observation::BoardH; y++) {
+        h = mix(h, s.board_rows[y]);
+        uint64_t cells = 0;
+        std::memcpy(&cells, s.board_cells[y], sizeof(s.board_cells[y]));
+        h = mix(h, cells);
+    }
+    h = mix(h, s.pieces.rng.state);
+    h = mix(h, s.pieces.rng.inc);
+    for (int i = s.pieces.pos; i < s.pieces.len && i < PieceSource::BlockSize; i++) {
+        h = mix(h, s.pieces.block[i]);
+    }
+    h = mix(h, static_cast<uint32_t>(s.score));
+    for (int i = 0; i < s.queue_size; i++) {
+        h = mix(h, s.queue[i]);
+    }
+    h = mix(h, (static_cast<uint64_t>(s.queue_index) << 48) | (static_cast<uint64_t>(s.holder_type) << 40) |
+               (static_cast<uint64_t>(static_cast<uint8_t>(s.current_x)) << 32) |
+               (static_cast<uint64_t>(static_cast<uint8_t>(s.current_y)) << 24) |
+               (static_cast<uint64_t>(s.current_piece_type) << 16) |
+               (static_cast<uint64_t>(s.rotation) << 8) | s.game_over);
+    return static_cast<uint32_t>(h ^ (h >> 32));
+}
+
+EpisodeRecorder::EpisodeRecorder(uint32_t seed, uint8_t queue_size, ActionMode action_mode,
+                                 bool include_hold, uint16_t checksum_interval, PieceRandomizer randomizer)
+    : header_{EpisodeLog::Version, static_cast<uint16_t>(include_hold ? EpisodeLog::IncludeHold : 0),
+              seed, queue_size, action_mode, checksum_interval, randomizer, 0, 0, 0},
+      start_{} {
+    // Replaying and checksumming both go through snapshots
+    if (queue_size == 0 || queue_size > GameState::MaxQueue) {
+        throw std::invalid_argument("episode logs support queue_size 1 to " + std::to_string(GameState::MaxQueue));
+    }
+    if (randomizer == PieceRandomizer::COMPAT) {
+        throw std::invalid_argument("COMPAT games cannot be logged");
+    }
+}
+
+EpisodeRecorder::EpisodeRecorder(const TetrisGame& game, ActionMode action_mode, bool include_hold,
+                                 uint16_t checksum_interval)
+    : EpisodeRecorder(0, static_cast<uint8_t>(game.queue_size), action_mode, include_hold, checksum_interval,
+                      game.pieces.randomizer) {
+    header_.flags |= EpisodeLog::HasStartState;
+    start_ = game.snapshot();
+    final_score_ = game.score;
+}
+
+void EpisodeRecorder::record(int32_t action, const TetrisGame& game) {
+    if (run_length_ > 0 && action != run_action_) {
+        flushRun();
+    }
+    run_action_ = action;
+    run_length_++;
+    num_steps_++;
+    final_score_ = game.score;
+    if (header_.checksum_interval && num_steps_ % header_.checksum_interval == 0) {
+        checksums_.push_back(EpisodeLog::checksum(game));
+    }
+}
+
+void EpisodeRecorder::clear() {
+    tokens_.clear();
+    checksums_.clear();
+    run_length_ = 0;
+    num_steps_ = 0;
+}
+
+void EpisodeRecorder::flushRun() {
+    const uint32_t zz = (static_cast<uint32_t>(run_action_) << 1) ^ static_cast<uint32_t>(run_action_ >> 31);
+    if (run_length_ == 1) {
+        putVarint(tokens_, static_cast<uint64_t>(zz) << 1);
+    } else {
+        putVarint(tokens_, (static_cast<uint64_t>(zz) << 1) | 1);
+        putVarint(tokens_, run_length_ - 2);
+    }
+    run_length_ = 0;
+}
+
+std::vector<uint8_t> EpisodeRecorder::serialize() const {
+    // The open run goes out on a copy so recording can continue
+    EpisodeRecorder done(*this);
+    if (done.run_length_ > 0) {
+        done.flushRun();
+    }
+
+    std::vector<uint8_t> out(EpisodeLog::Magic, EpisodeLog::Magic + 4);
+    out.reserve(EpisodeLog::HeaderSize + sizeof(GameState) + done.tokens_.size() + 4 * done.checksums_.size());
+    putU16(out, header_.version);
+    putU16(out, header_.flags);
+    putU32(out, header_.seed);
+    out.push_back(header_.queue_size);
+    out.push_back(static_cast<uint8_t>(header_.action_mode));
+    putU16(out, header_.checksum_interval);
+    putU32(out, num_steps_);
+    putU32(out, static_cast<uint32_t>(final_score_));
+    putU32(out, static_cast<uint32_t>(done.tokens_.size()));
+    out.push_back(static_cast<uint8_t>(header_.randomizer));
+    out.insert(out.end(), 3, 0);  // reserved
+
+    if (header_.flags & EpisodeLog::HasStartState) {
+        const uint8_t* raw = reinterpret_cast<const uint8_t*>(&start_);
+        out.insert(out.end(), raw, raw + sizeof(GameState));
+    }
+    out.insert(out.end(), done.tokens_.begin(), done.tokens_.end());
+    for (uint32_t c : done.checksums_) {
+        putU32(out, c);
+    }
+    return out;
+}
+
+EpisodeReplayer::EpisodeReplayer(const uint8_t* data, size_t size) : start_{} {
+    Reader in(data, size);
+    if (std::memcmp(in.take(4), EpisodeLog::Magic, 4) != 0) {
+        throw std::invalid_argument("not an episode log");
+    }
+    header_.version = in.u16();
+    if (header_.version != EpisodeLog::Version) {
+        throw std::invalid_argument("unsupported episode log version");
+    }
+    header_.flags = in.u16();
+    header_.seed = in.u32();
+    header_.queue_size = in.u8();
+    header_.action_mode = static_cast<ActionMode>(in.u8());
+    header_.checksum_interval = in.u16();
+    header_.num_steps = in.u32();
+    header_.final_score = static_cast<int32_t>(in.u32());
+    header_.action_bytes = in.u32();
+    header_.randomizer = static_cast<PieceRandomizer>(in.u8());
+    in.take(3);  // reserved
+    if (header_.queue_size == 0 || header_.queue_size > GameState::MaxQueue ||
+        header_.action_mode > ActionMode::PLACEMENT || header_.randomizer > PieceRandomizer::BAG7) {
+        throw std::invalid_argument("episode log header is corrupt");
+    }
+
+    game_ = std::make_unique<TetrisGame>(TimeManager::SIMULATION, header_.queue_size, header_.seed,
+                                         header_.randomizer);
+    if (header_.flags & EpisodeLog::HasStartState) {
+        std::memcpy(&start_, in.take(sizeof(GameState)), sizeof(GameState));
+        if (!game_->restore(start_)) {
+            throw std::invalid_argument("episode log start state does not match its queue_size");
+        }
+    } else {
+        start_ = game_->snapshot();
+    }
+
+    Reader tokens(in.take(header_.action_bytes), header_.action_bytes);
+    actions_.reserve(header_.num_steps);
+    while (tokens.remaining() > 0) {
+        const uint64_t token = tokens.varint();
+        const uint32_t zz = static_cast<uint32_t>(token >> 1);
+        const int32_t action = static_cast<int32_t>((zz >> 1) ^ (0u - (zz & 1)));
+        const uint64_t count = (token & 1) ? tokens.varint() + 2 : 1;
+        if (actions_.size() + count > header_.num_steps) {
+            throw std::invalid_argument("episode log has more actions than steps");
+        }
+        actions_.insert(actions_.end(), count, action);
+    }
+    if (actions_.size() != header_.num_steps) {
+        throw std::invalid_argument("episode log has fewer actions than steps");
+    }
+
+    const size_t num_checksums = header_.checksum_interval ? header_.num_steps / header_.checksum_interval : 0;
+    checksums_.reserve(num_checksums);
+    for (size_t i = 0; i < num_checksums; i++) {
+        checksums_.push_back(in.u32());
+    }
+}
+
+void EpisodeReplayer::rewind() {
+    game_->restore(start_);
+    position_ = 0;
+}
+
+bool EpisodeReplayer::step() {
+    if (position_ >= actions_.size()) {
+        return false;
+    }
+    const int32_t action = actions_[position_++];
+    if (header_.action_mode == ActionMode::PLACEMENT) {
+        game_->enumeratePlacements((header_.flags & EpisodeLog::IncludeHold) != 0);
+        game_->stepPlacement(static_cast<size_t>(action));
+    } else {
+        game_->step(action);
+    }
+    return true;
+}
+
+bool EpisodeReplayer::seek(size_t steps) {
+    if (steps > actions_.size()) {
+        return false;
+    }
+    if (steps < position_) {
+        rewind();
+    }
+    while (position_ < steps) {
+        step();
+    }
+    return true;
+}
+
+int64_t EpisodeReplayer::verify() {
+    rewind();
+    const uint16_t interval = header_.checksum_interval;
+    while (step()) {
+        if (interval && position_ % interval == 0 &&
+            EpisodeLog::checksum(*game_) != checksums_[position_ / interval - 1]) {
+            return static_cast<int64_t>(position_ - 1);
+        }
+    }
+    return -1;
+}
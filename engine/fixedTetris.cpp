@@ -0,0 +1,5 @@
+#include "fixedTetris.h"
+
+template class FixedTetris<10, 20, 3>;
+template class FixedTetris<6, 12, 3>;
+template class FixedTetris<10, 40, 3>;
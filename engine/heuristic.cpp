@@ -0,0 +1,97 @@
+/* Plays whole games with the native heuristic agent and reports throughput.
+ *
+ *   tetris_heuristic [--games N] [--seed S] [--threads T] [--max-pieces M] [--hold]
+ *
+ * Game i uses seed S + i, split across T threads.
+ * */
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <thread>
+#include <vector>
+
+#include "heuristicAgent.h"
+#include "tetrisGame.h"
+
+struct Options {
+    uint32_t games = 32;
+    uint32_t seed = 0;
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint32_t max_pieces = 10000;
+    bool use_hold = false;
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--hold") == 0) {
+            options.use_hold = true;
+        } else if (std::strcmp(argv[i], "--games") == 0 && has_value) {
+            options.games = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--seed") == 0 && has_value) {
+            options.seed = std::strtoul(argv[++i], nullptr, 10);
+        } else if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            options.threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--max-pieces") == 0 && has_value) {
+            options.max_pieces = std::strtoul(argv[++i], nullptr, 10);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0]
+                  << " [--games N] [--seed S] [--threads T] [--max-pieces M] [--hold]" << std::endl;
+        return 1;
+    }
+
+    std::vector<HeuristicAgent::GameStats> stats(options.games);
+    std::vector<std::thread> threads;
+    const uint32_t num_threads = std::min(options.threads, std::max(options.games, 1u));
+
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t t = 0; t < num_threads; t++) {
+        threads.emplace_back([&options, &stats, t, num_threads]() {
+            HeuristicAgent agent(LinearValue::elTetris(), HeuristicAgent::ElTetrisLandingHeight, options.use_hold);
+            TetrisGame game(TimeManager::SIMULATION, 3, options.seed);
+            for (uint32_t i = t; i < options.games; i += num_threads) {
+                game.pieces.reseed(options.seed + i);
+                game.reset();
+                stats[i] = agent.play(game, options.max_pieces);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t pieces = 0;
+    uint64_t lines = 0;
+    uint32_t topped_out = 0;
+    uint32_t min_lines = UINT32_MAX;
+    uint32_t max_lines = 0;
+    for (const auto& s : stats) {
+        pieces += s.pieces;
+        lines += s.lines;
+        topped_out += s.topped_out;
+        min_lines = std::min(min_lines, s.lines);
+        max_lines = std::max(max_lines, s.lines);
+    }
+    const double games = std::max(options.games, 1u);
+
+    std::cout << "games:        " << options.games << " (" << topped_out << " topped out, "
+              << num_threads << " threads)" << std::endl;
+    std::cout << "pieces/sec:   " << static_cast<uint64_t>(pieces / seconds) << std::endl;
+    std::cout << "pieces/game:  " << pieces / games << std::endl;
+    std::cout << "lines/game:   " << lines / games << " (min " << (options.games ? min_lines : 0)
+              << ", max " << max_lines << ")" << std::endl;
+    std::cout << "elapsed:      " << seconds << " s" << std::endl;
+    return 0;
+}
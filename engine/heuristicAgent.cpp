@@ -0,0 +1,69 @@
+#include "heuristicAgent.h"
+#include "pieceTables.h"
+#include <algorithm>
+
+HeuristicAgent::HeuristicAgent(const LinearValue& value, float landing_height_weight, bool use_hold)
+    : landing_height_weight_(landing_height_weight), use_hold_(use_hold) {
+    for (int i = 0; i < TetrisGame::AfterstateSize; i++) {
+        if (value.weights[i] != 0.0f) {
+            terms_.push_back(i);
+            term_weights_.push_back(value.weights[i]);
+        }
+    }
+}
+
+void HeuristicAgent::scorePlacements(const std::vector<Placement>& placements, float* scores) {
+    const size_t n = placements.size();
+    const size_t num_terms = terms_.size();
+    columns_.resize((num_terms + 1) * n);
+
+    // Transpose into one column per term; the last column is landing height,
+    // the mid row of the locked piece
+    float row[TetrisGame::AfterstateSize];
+    float* landing = columns_.data() + num_terms * n;
+    for (size_t i = 0; i < n; i++) {
+        const Placement& p = placements[i];
+        TetrisGame::writeAfterstate(p, row);
+        for (size_t t = 0; t < num_terms; t++) {
+            columns_[t * n + i] = row[terms_[t]];
+        }
+        const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[p.piece_type][p.rotation];
+        landing[i] = p.y + 0.5f * (shape.min_y + shape.max_y);
+    }
+
+    for (size_t i = 0; i < n; i++) {
+        scores[i] = landing_height_weight_ * landing[i];
+    }
+    for (size_t t = 0; t < num_terms; t++) {
+        const float w = term_weights_[t];
+        const float* column = columns_.data() + t * n;
+        for (size_t i = 0; i < n; i++) {
+            scores[i] += w * column[i];
+        }
+    }
+}
+
+int HeuristicAgent::choose(TetrisGame& game) {
+    const std::vector<Placement>& placements = game.enumeratePlacements(use_hold_);
+    if (placements.empty()) {
+        return -1;
+    }
+    scores_.resize(placements.size());
+    scorePlacements(placements, scores_.data());
+    return static_cast<int>(std::max_element(scores_.begin(), scores_.end()) - scores_.begin());
+}
+
+HeuristicAgent::GameStats HeuristicAgent::play(TetrisGame& game, uint32_t max_pieces) {
+    GameStats stats{0, 0, false};
+    while (!game.isGameOver() && stats.pieces < max_pieces) {
+        const int index = choose(game);
+        if (index < 0) {
+            break;
+        }
+        const StepResult result = game.stepPlacement(static_cast<size_t>(index));
+        stats.pieces++;
+        stats.lines += static_cast<uint32_t>(result.reward);
+    }
+    stats.topped_out = game.isGameOver();
+    return stats;
+}
@@ -0,0 +1,94 @@
+#include "hostTuning.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <thread>
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
+namespace {
+constexpr size_t HugePageSize = size_t{2} << 20;
+}
+
+std::vector<int> allowedCpus() {
+    std::vector<int> cpus;
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; cpu++) {
+            if (CPU_ISSET(cpu, &set)) {
+                cpus.push_back(cpu);
+            }
+        }
+    }
+#endif
+    if (cpus.empty()) {
+        const int count = static_cast<int>(std::max(1u, std::thread::hardware_concurrency()));
+        for (int cpu = 0; cpu < count; cpu++) {
+            cpus.push_back(cpu);
+        }
+    }
+    return cpus;
+}
+
+bool pinCurrentThread(int cpu) {
+#if defined(__linux__)
+    if (cpu < 0 || cpu >= CPU_SETSIZE) {
+        return false;
+    }
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    return pthread_setaffinity_np(pthread_self(), sizeof(set), &set) == 0;
+#else
+    (void)cpu;
+    return false;
+#endif
+}
+
+void* allocateHugePages(size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (bytes == 0) {
+        return nullptr;
+    }
+    // Over-allocate so the returned range starts on a huge-page boundary,
+    // then give back the slack on both sides
+    const size_t length = (bytes + HugePageSize - 1) / HugePageSize * HugePageSize;
+    void* raw = mmap(nullptr, length + HugePageSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (raw == MAP_FAILED) {
+        return nullptr;
+    }
+    const uintptr_t start = reinterpret_cast<uintptr_t>(raw);
+    const uintptr_t aligned = (start + HugePageSize - 1) & ~(HugePageSize - 1);
+    if (aligned > start) {
+        munmap(raw, aligned - start);
+    }
+    const size_t tail = start + length + HugePageSize - (aligned + length);
+    if (tail) {
+        munmap(reinterpret_cast<void*>(aligned + length), tail);
+    }
+    void* ptr = reinterpret_cast<void*>(aligned);
+    // Transparent huge pages only; no hugetlbfs reservation needed
+    madvise(ptr, length, MADV_HUGEPAGE);
+    return ptr;
+#else
+    (void)bytes;
+    return nullptr;
+#endif
+}
+
+void freeHugePages(void* ptr, size_t bytes) {
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    if (ptr) {
+        munmap(ptr, (bytes + HugePageSize - 1) / HugePageSize * HugePageSize);
+    }
+#else
+    (void)ptr;
+    (void)bytes;
+#endif
+}
@@ -1,42 +1,111 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <chrono>
 #include <condition_variable>
 #include <cstdint>
+#include <exception>
+#include <functional>
+#include <map>
 #include <memory>
 #include <mutex>
-#include <queue>
 #include <thread>
 #include <vector>
 
+#include <pybind11/numpy.h>
 #include <pybind11/pybind11.h>
 
+#include "hostTuning.h"
+#include "mlpPolicy.h"
+#include "mpmcQueue.h"
 #include "tetrisGame.h"
+#include "workerPool.h"
 
 namespace py = pybind11;
 
+// How workers get their actions from policy_fn
+enum class PolicyBatching : uint8_t {
+    PER_WORKER,  // each worker calls policy_fn(obs[obs_dim]) itself
+    LOCKSTEP,    // all envs step together, one policy_fn(obs[n, obs_dim]) per step
+    DYNAMIC      // workers queue observations; batches go out when full or on a deadline
+};
+
 struct EpisodeJob {
     uint64_t job_id;
     uint32_t max_steps;
+    size_t slot;  // row of the output arrays this episode fills
 };
 
 struct EpisodeResult {
     uint64_t job_id;
+    size_t slot;
     uint32_t length;
-    std::vector<float> observations;
-    std::vector<float> rewards;
-    std::vector<int32_t> actions;
-    std::vector<float> log_probs;
-    std::vector<float> values;
-    std::vector<uint8_t> dones;
 };
 
-struct WorkerBuffers {
-    std::vector<float> observations;
-    std::vector<float> rewards;
-    std::vector<int32_t> actions;
-    std::vector<float> log_probs;
-    std::vector<float> values;
-    std::vector<uint8_t> dones;
+// The arrays request_episodes (or request_segments) returns, allocated
+// before collection starts. The worker playing the episode in row `slot`
+// writes its steps in place and clears the padding after its last step;
+// segments have one row per env and no padding.
+struct EpisodeOutputs {
+    size_t steps = 0;                 // columns per row: max_steps, or the segment length
+    uint8_t* observations = nullptr;  // [rows, steps, stored_obs_dim] floats or bytes
+    int32_t* actions = nullptr;       // the rest are [rows, steps]
+    float* log_probs = nullptr;
+    float* values = nullptr;
+    float* rewards = nullptr;
+    uint8_t* dones = nullptr;
+    uint32_t* lengths = nullptr;      // episodes only, [rows]
+    uint8_t* truncated = nullptr;     // segments only: the step hit max_steps
+    uint8_t* next_observations = nullptr;  // segments only, [rows, stored_obs_dim]
+};
+
+// One per worker, allocated by that worker. Aligned so workers resizing
+// their scratch rows never write to a cache line another worker reads.
+struct alignas(CacheLineSize) WorkerBuffers {
+    std::vector<float> observations;  // the policy's current row when observations aren't stored as floats
+    std::vector<float> afterstates;   // PLACEMENT mode scratch, one row per placement
+    uint32_t segment_length = 0;      // segment mode: steps into the env's current game
+    PieceRng policy_rng;              // native policy: action sampling for this env
+    MlpPolicy::Scratch mlp;           // native policy: activations
+};
+
+// A worker's pending DYNAMIC policy call
+struct PolicyRequest {
+    size_t worker;
+    const float* obs;  // obs_dim floats, valid until the reply
+    size_t num_placements;
+    std::chrono::steady_clock::time_point submitted;
+};
+
+// Where the broker leaves a worker's action; one per worker, reused every step
+struct alignas(CacheLineSize) PolicyFuture {
+    std::mutex mutex;
+    std::condition_variable cv;
+    bool ready = false;
+    bool failed = false;  // policy_fn raised; the episode ends here
+    int action = 0;
+    float log_prob = 0.0f;
+    float value = 0.0f;
+};
+
+// DYNAMIC batching histograms, reset by each request_episodes call
+struct BrokerStats {
+    static constexpr size_t LatencyBuckets = 24;
+    std::vector<uint64_t> batch_sizes;  // [size] = policy calls with that many rows
+    // [b] = requests that waited under 2^b us from submission to the policy call
+    std::array<uint64_t, LatencyBuckets> queue_latency_us{};
+};
+
+// One submit() call, collected by its own coordinator thread so Python can
+// train on the previous batch meanwhile
+struct SubmittedBatch {
+    size_t num_episodes = 0;  // 0 for a segment batch
+    int64_t policy_version;
+    std::thread coordinator;
+    std::atomic<bool> done{false};
+    py::dict arrays;  // written in place by the workers
+    std::exception_ptr error;
 };
 
 class BatchedTetrisCollector {
@@ -44,41 +113,185 @@ public:
     BatchedTetrisCollector(size_t num_workers,
                            uint32_t max_steps,
                            uint8_t queue_size = 3,
-                           uint32_t seed_base = 0);
+                           uint32_t seed_base = 0,
+                           ObsMode obs_mode = ObsMode::BOARD,
+                           ActionMode action_mode = ActionMode::PRIMITIVE,
+                           PieceRandomizer randomizer = PieceRandomizer::UNIFORM,
+                           ObsDtype obs_dtype = ObsDtype::FLOAT32,
+                           bool pin_workers = false,
+                           bool huge_pages = false);
     ~BatchedTetrisCollector();
 
-    py::dict request_episodes(size_t num_episodes, py::function policy_fn);
+    // PER_WORKER: each worker plays its own episodes and calls
+    // policy_fn(obs[obs_dim]) -> (action, log_prob, value) per step.
+    // LOCKSTEP and DYNAMIC: policy_fn gets obs[n, obs_dim] (plus a list of n
+    // afterstate arrays in PLACEMENT mode) and returns (actions[n],
+    // log_probs[n], values[n]). LOCKSTEP steps every env together, replacing
+    // finished episodes until num_episodes have been played; DYNAMIC lets
+    // workers run freely and batches whatever requests are queued.
+    // policy_fn None: the native policy from set_policy_weights, which
+    // every worker runs itself without the GIL (batching is ignored).
+    py::dict request_episodes(size_t num_episodes, py::object policy_fn,
+                              PolicyBatching batching = PolicyBatching::PER_WORKER);
+    // Starts collecting like request_episodes and returns at once with a
+    // handle for poll()/wait(). One batch collects at a time; finished ones
+    // wait for wait(), so the learner can consume batch v while batch v+1
+    // is collected. policy_version is returned with the batch.
+    uint64_t submit(size_t num_episodes, py::object policy_fn,
+                    PolicyBatching batching = PolicyBatching::PER_WORKER, int64_t policy_version = 0);
+    // Fixed-horizon collection: every env plays num_steps more steps, one
+    // batched policy_fn call per step as with LOCKSTEP. Envs keep their
+    // games between calls and reset as soon as one ends (terminated, or
+    // truncated at max_steps; max_steps 0 never truncates), so each row is
+    // num_steps of continuous experience with no padding. Returns
+    // [num_envs, num_steps] arrays plus next_observations, each env's
+    // observation after its last step, for bootstrapping. With policy_fn
+    // None the pool threads run the native policy on their envs as one
+    // batch each, and the GIL is released for the whole call.
+    py::dict request_segments(uint32_t num_steps, py::object policy_fn);
+    // As submit(), for a segment batch; wait() returns it
+    uint64_t submit_segments(uint32_t num_steps, py::object policy_fn, int64_t policy_version = 0);
+    bool poll(uint64_t handle) const;
+    // Blocks until the batch is collected and returns it (or rethrows
+    // policy_fn's error). Each handle can be waited on once.
+    py::dict wait(uint64_t handle);
     void close();
 
+    // The network policy_fn=None runs (null clears it). Collections pick it
+    // up when they start, and workers again at each episode, so swapping
+    // weights between iterations needs no other synchronization.
+    void set_policy_weights(std::shared_ptr<const MlpPolicy> policy);
+    std::shared_ptr<const MlpPolicy> native_policy() const;
+
+    // DYNAMIC batching: a batch goes out once it has max_batch_size
+    // requests, every busy worker is waiting, or its oldest request has
+    // waited max_wait_us
+    size_t max_batch_size() const { return max_batch_size_; }
+    void set_max_batch_size(size_t size);
+    uint32_t max_wait_us() const { return max_wait_us_; }
+    void set_max_wait_us(uint32_t us) { max_wait_us_ = us; }
+    const BrokerStats& broker_stats() const { return broker_stats_; }
+
+    size_t num_envs() const { return envs_.size(); }
     uint32_t obs_dim() const { return obs_dim_; }
     uint32_t max_steps() const { return max_steps_; }
+    ObsMode obs_mode() const { return obs_mode_; }
+    ActionMode action_mode() const { return action_mode_; }
+    ObsDtype obs_dtype() const { return obs_dtype_; }
+    // Last dimension of the observations array: obs_dim, or the packed
+    // row size for ObsDtype::PACKED
+    uint32_t stored_obs_dim() const { return stored_obs_dim_; }
+    // pin_workers: worker i runs on the i-th allowed CPU (wrapping), as
+    // does the pool thread stepping env i in LOCKSTEP and segment mode
+    bool pin_workers() const { return !worker_cpus_.empty(); }
+    // huge_pages: observation arrays are 2 MiB-aligned and advised for
+    // transparent huge pages, where the OS allows it
+    bool huge_pages() const { return huge_pages_; }
+    // Columns of the afterstates array in PLACEMENT mode (TetrisGame::writeAfterstate)
+    static constexpr uint32_t afterstate_dim() { return TetrisGame::AfterstateSize; }
+    // PRIMITIVE actions a policy picks from: LEFT through SWAP (Python's Discrete(7))
+    static constexpr size_t num_actions() { return static_cast<size_t>(SWAP) + 1; }
 
 private:
-    void worker_loop(size_t worker_idx);
+    // Pins the worker (if asked) and allocates its env and buffers
+    void init_worker(size_t worker_idx, uint32_t seed, PieceRandomizer randomizer);
+    void worker_loop(size_t worker_idx, uint32_t seed, PieceRandomizer randomizer);
+    // A [..., stored_obs_dim] array in obs_dtype_, on huge pages if enabled
+    py::array observation_array(const std::vector<ssize_t>& shape) const;
+    // Allocates the output arrays and resets the per-collection state; GIL
+    // held, no collection running
+    py::dict begin_collection(size_t num_episodes, PolicyBatching batching);
+    // Plays num_episodes with policy_callback_ into outputs_; called without the GIL
+    void collect(size_t num_episodes, PolicyBatching batching);
+    bool collecting() const;
+    // Records policy_fn for the collection about to start; None selects
+    // the native policy
+    void select_policy(py::object policy_fn);
+    // Runs collect_fn on a coordinator thread and returns its handle
+    uint64_t start_submission(py::dict arrays, size_t num_episodes, int64_t policy_version,
+                              std::function<void()> collect_fn);
+    void collect_lockstep(size_t num_episodes);
+    py::dict begin_segments(uint32_t num_steps);
+    // GIL held; released while the envs step
+    void collect_segments(uint32_t num_steps);
+    // The DYNAMIC broker: runs on its own thread until every episode is done
+    void run_broker();
+    void serve_batch(const std::vector<PolicyRequest>& batch);
+    // Queues a DYNAMIC request and waits for its reply; false if policy_fn failed
+    bool request_policy(size_t worker, const float* obs, size_t num_placements,
+                        int& action, float& log_prob, float& value);
+    // Calls policy_fn on rows of obs (GIL held); rows[i]'s afterstates are in
+    // buffers_[envs[i]]. Fills actions, log_probs, values with one entry per row.
+    void call_batched_policy(const py::array_t<float>& obs, const std::vector<size_t>& envs,
+                             const std::vector<size_t>& num_placements, std::vector<int32_t>& actions,
+                             std::vector<float>& log_probs, std::vector<float>& values);
+    // Records step `step`'s observation in row `slot` and writes the
+    // policy's float row to policy_obs (which may be that row); returns the
+    // placement count in PLACEMENT mode
+    size_t prepare_step(TetrisGame& env, WorkerBuffers& buf, size_t slot, uint32_t step, float* policy_obs) const;
+    StepResult apply_action(TetrisGame& env, size_t slot, uint32_t step,
+                            int action, float log_prob, float value) const;
+    // Sets the episode's length and clears row `slot` after it
+    void finish_episode(size_t slot, uint32_t length) const;
+    float* float_observation(size_t slot, uint32_t step) const;
+    size_t write_observation(TetrisGame& env, float* dest) const;
+    // The current observation in obs_dtype_ form, stored_obs_dim_ bytes
+    void store_observation(TetrisGame& env, uint8_t* dest) const;
+    size_t write_afterstates(TetrisGame& env, std::vector<float>& dest) const;
     size_t flatten_observation(const Observation& obs, float* dest) const;
     static size_t compute_obs_dim(const Observation& obs);
-    void enqueue_job(EpisodeJob job);
-    EpisodeJob take_job();
-    void push_result(EpisodeResult&& result);
-    EpisodeResult take_result();
 
     const uint32_t max_steps_;
     const uint8_t queue_size_;
+    const ObsMode obs_mode_;
+    const ActionMode action_mode_;
+    const ObsDtype obs_dtype_;
+    const bool huge_pages_;
     uint32_t obs_dim_;
+    uint32_t stored_obs_dim_;
 
     std::vector<std::thread> workers_;
+    std::vector<int> worker_cpus_;  // empty unless pin_workers
+    // Filled by the workers themselves before the constructor returns
     std::vector<std::unique_ptr<TetrisGame>> envs_;
-    std::vector<WorkerBuffers> buffers_;
+    std::vector<std::unique_ptr<WorkerBuffers>> buffers_;
+    std::mutex init_mutex_;
+    std::condition_variable init_cv_;
+    size_t workers_ready_ = 0;
+    std::exception_ptr init_error_;
 
-    std::queue<EpisodeJob> job_queue_;
-    std::queue<EpisodeResult> result_queue_;
-    std::mutex job_mutex_;
-    std::mutex result_mutex_;
-    std::condition_variable job_cv_;
-    std::condition_variable result_cv_;
+    // Bounded; collect() tops the job queue up as results come back. The
+    // result queue has room for every job in flight, so workers never wait
+    // to hand one back.
+    MpmcQueue<EpisodeJob> job_queue_;
+    MpmcQueue<EpisodeResult> result_queue_;
 
-    bool shutting_down_ = false;
+    std::atomic<bool> shutting_down_{false};
     uint64_t next_job_id_ = 0;
 
     py::object policy_callback_;
+    std::shared_ptr<const MlpPolicy> native_policy_;
+    mutable std::mutex native_mutex_;
+    bool use_native_ = false;  // this collection runs native_policy_
+    // Steps the envs between lockstep policy calls; created on first use
+    std::unique_ptr<WorkerPool> lockstep_pool_;
+    // Segment mode: whether envs_ hold games to continue (episode
+    // collection leaves them finished)
+    bool segments_started_ = false;
+
+    PolicyBatching batching_ = PolicyBatching::PER_WORKER;
+    size_t max_batch_size_;
+    uint32_t max_wait_us_ = 200;
+    std::vector<std::unique_ptr<PolicyFuture>> futures_;
+    std::vector<PolicyRequest> pending_requests_;
+    size_t episodes_left_ = 0;
+    bool broker_failed_ = false;
+    std::exception_ptr broker_error_;
+    std::mutex broker_mutex_;
+    std::condition_variable broker_cv_;
+    BrokerStats broker_stats_;
+
+    EpisodeOutputs outputs_;
+    std::map<uint64_t, std::unique_ptr<SubmittedBatch>> submissions_;
+    uint64_t next_handle_ = 0;
 };
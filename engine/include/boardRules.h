@@ -0,0 +1,157 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include "pieceTables.h"
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// The board half of the game rules, shared by TetrisGame, VecTetris and
+// FixedTetris. Works on one board's arrays:
+//   rows[Rows]      one bitmask per row, bit (x + Wall) is column x; the
+//                   bits outside the W playable columns are always set, so
+//                   walls collide like locked cells and a full row == FullRow
+//   cells[Rows * W] piece_type + 1, 0 = empty
+//   heights[W]      1 + topmost filled row of each column, 0 when empty
+// Rows bounds collisions and locking; only the bottom H rows can clear.
+template <int W, int Rows, int H>
+struct BoardRules {
+    static constexpr int Width = W;
+    static constexpr int Wall = 3;
+    static constexpr uint16_t FullRow = 0xFFFF;
+    static constexpr uint16_t EmptyRow = static_cast<uint16_t>(~(((1u << W) - 1) << Wall));
+
+    static_assert(W >= Tetris::PIECE_SIZE && W + Wall <= 16, "rows are 16-bit masks with a 3-bit wall");
+    static_assert(H >= Tetris::PIECE_SIZE && H <= Rows && Rows <= 127, "y must fit in int8_t");
+
+    static bool collides(const uint16_t* rows, uint8_t type, int x, int y, uint8_t rot) {
+        const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[type][rot];
+        // Bounds against the bounding box once instead of per cell
+        if (x + shape.min_x < 0 || x + shape.max_x >= W || y + shape.min_y < 0 || y + shape.max_y >= Rows) {
+            return true;
+        }
+        // One AND per occupied row
+        const int shift = x + Wall;
+        for (int r = shape.min_y; r <= shape.max_y; r++) {
+            if (rows[y + r] & static_cast<uint16_t>(shape.rows[r] << shift)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Height of column x counting only rows below `top`
+    static uint8_t columnHeightBelow(const uint16_t* rows, int x, int top) {
+        const uint16_t bit = static_cast<uint16_t>(1u << (x + Wall));
+        for (int y = top - 1; y >= 0; y--) {
+            if (rows[y] & bit) {
+                return static_cast<uint8_t>(y + 1);
+            }
+        }
+        return 0;
+    }
+
+    // Where a hard drop from (x, y) comes to rest
+    static int landingY(const uint16_t* rows, const uint8_t* heights, uint8_t type, int x, int y, uint8_t rot) {
+        const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[type][rot];
+        if (x + shape.min_x >= 0 && x + shape.max_x < W && y + shape.max_y < Rows) {
+            // Everything above the surface is empty, so a piece starting above
+            // it falls straight onto it
+            const int landing = Tetris::surfaceLandingY(shape, heights, x);
+            if (landing <= y) {
+                return landing;
+            }
+        }
+        // Tucked under an overhang (or out of bounds): scan down like a real drop
+        while (!collides(rows, type, x, y, rot)) {
+            y -= 1;
+        }
+        return y + 1;
+    }
+
+    // x in [0, W), y in [0, Rows); out of range is ignored
+    static void setCell(uint16_t* rows, uint8_t* cells, uint8_t* heights, int x, int y, uint8_t value) {
+        if (x < 0 || x >= W || y < 0 || y >= Rows) {
+            return;
+        }
+        cells[y * W + x] = value;
+        const uint16_t bit = static_cast<uint16_t>(1u << (x + Wall));
+        if (value) {
+            rows[y] |= bit;
+            heights[x] = std::max<uint8_t>(heights[x], static_cast<uint8_t>(y + 1));
+        } else {
+            rows[y] &= static_cast<uint16_t>(~bit);
+            if (heights[x] == y + 1) {
+                heights[x] = columnHeightBelow(rows, x, y);
+            }
+        }
+    }
+
+    // Writes the piece's cells (piece_type + 1); cells off the board are dropped
+    static void lockPiece(uint16_t* rows, uint8_t* cells, uint8_t* heights, uint8_t type, int x, int y,
+                          uint8_t rot) {
+        const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[type][rot];
+        for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+            const int board_y = y + shape.cell_y[i];
+            const int board_x = x + shape.cell_x[i];
+            if (board_y >= 0 && board_y < Rows && board_x >= 0 && board_x < W) {
+                cells[board_y * W + board_x] = static_cast<uint8_t>(type + 1);
+                rows[board_y] |= static_cast<uint16_t>(1u << (board_x + Wall));
+                heights[board_x] = std::max<uint8_t>(heights[board_x], static_cast<uint8_t>(board_y + 1));
+            }
+        }
+    }
+
+    // Full rows among the four a piece at y covers: bit r = row y + r
+    static unsigned fullRows(const uint16_t* rows, int y) {
+        unsigned full = 0;
+#if defined(__SSE2__) || defined(_M_X64)
+        if (y >= 0 && y + Tetris::PIECE_SIZE <= H) {
+            const __m128i four_rows = _mm_loadl_epi64(reinterpret_cast<const __m128i*>(rows + y));
+            const int bytes = _mm_movemask_epi8(_mm_cmpeq_epi16(four_rows, _mm_set1_epi16(-1)));
+            for (int r = 0; r < Tetris::PIECE_SIZE; r++) {
+                full |= ((bytes >> (2 * r)) & 1u) << r;
+            }
+            return full;
+        }
+#endif
+        for (int r = 0; r < Tetris::PIECE_SIZE; r++) {
+            const int row = y + r;
+            if (row >= 0 && row < H && rows[row] == FullRow) {
+                full |= 1u << r;
+            }
+        }
+        return full;
+    }
+
+    // Removes row (< H): the rows above it up to H shift down one and row
+    // H - 1 comes in empty. Rows from H up don't move.
+    static void clearRow(uint16_t* rows, uint8_t* cells, uint8_t* heights, int row) {
+        const int above = H - 1 - row;
+        std::memmove(rows + row, rows + row + 1, above * sizeof(uint16_t));
+        std::memmove(cells + row * W, cells + (row + 1) * W, above * W);
+        rows[H - 1] = EmptyRow;
+        std::memset(cells + (H - 1) * W, 0, W);
+        // Columns topped above the row drop by one, a column topped by the
+        // cleared row needs a rescan
+        for (int x = 0; x < W; x++) {
+            const int height = heights[x];
+            if (height > H || height <= row) {
+                continue;
+            }
+            heights[x] = height == row + 1 ? columnHeightBelow(rows, x, row) : static_cast<uint8_t>(height - 1);
+        }
+    }
+
+    // Removes the rows fullRows(rows, y) reported, topmost first so the
+    // rows still pending keep their indices
+    static void clearRows(uint16_t* rows, uint8_t* cells, uint8_t* heights, int y, unsigned full) {
+        for (int r = Tetris::PIECE_SIZE - 1; r >= 0; r--) {
+            if (full & (1u << r)) {
+                clearRow(rows, cells, heights, y + r);
+            }
+        }
+    }
+};
@@ -0,0 +1,108 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "tetrisGame.h"
+
+// Compact episode logs. A game is fully determined by where it starts
+// (a fresh TetrisGame for a seed and randomizer, or a GameState snapshot) and
+// its actions, so that is all a log holds:
+//
+//   header     32 bytes, little endian (EpisodeLog::Header)
+//   start      sizeof(GameState) raw bytes, only with HasStartState
+//   actions    action_bytes of run-length tokens: varint(zigzag(a) << 1 | run),
+//              followed by varint(count - 2) when run is set
+//   checksums  u32 per checksum_interval steps (none when the interval is 0)
+//
+// Replaying regenerates observations at engine speed, and the checksums
+// pin down the first step where a changed engine diverges.
+namespace EpisodeLog {
+
+constexpr char Magic[4] = {'T', 'T', 'E', 'L'};
+constexpr uint16_t Version = 1;
+
+enum Flags : uint16_t {
+    HasStartState = 1 << 0,
+    IncludeHold = 1 << 1,   // placement indices enumerate with the held piece
+};
+
+struct Header {
+    uint16_t version;
+    uint16_t flags;
+    uint32_t seed;
+    uint8_t queue_size;
+    ActionMode action_mode;
+    uint16_t checksum_interval;
+    PieceRandomizer randomizer;
+    uint32_t num_steps;
+    int32_t final_score;
+    uint32_t action_bytes;
+};
+constexpr size_t HeaderSize = 32;
+
+// Hash of everything a GameState holds (board, pieces, score, RNG)
+uint32_t checksum(const TetrisGame& game);
+
+}  // namespace EpisodeLog
+
+class EpisodeRecorder {
+public:
+    // An episode of a fresh TetrisGame(SIMULATION, queue_size, seed, randomizer)
+    EpisodeRecorder(uint32_t seed, uint8_t queue_size, ActionMode action_mode = ActionMode::PRIMITIVE,
+                    bool include_hold = false, uint16_t checksum_interval = 1,
+                    PieceRandomizer randomizer = PieceRandomizer::UNIFORM);
+    // An episode starting from game's current state (stored as a snapshot)
+    explicit EpisodeRecorder(const TetrisGame& game, ActionMode action_mode = ActionMode::PRIMITIVE,
+                             bool include_hold = false, uint16_t checksum_interval = 1);
+
+    // Call after each step with the action taken and the game it was applied to
+    void record(int32_t action, const TetrisGame& game);
+    void clear();
+
+    size_t numSteps() const { return num_steps_; }
+    std::vector<uint8_t> serialize() const;
+
+private:
+    void flushRun();
+
+    EpisodeLog::Header header_;
+    GameState start_;
+    std::vector<uint8_t> tokens_;
+    std::vector<uint32_t> checksums_;
+    int32_t run_action_ = 0;
+    uint32_t run_length_ = 0;
+    uint32_t num_steps_ = 0;
+    int32_t final_score_ = 0;
+};
+
+class EpisodeReplayer {
+public:
+    // Parses a serialized log; throws std::invalid_argument if it is malformed
+    EpisodeReplayer(const uint8_t* data, size_t size);
+
+    const EpisodeLog::Header& header() const { return header_; }
+    size_t numSteps() const { return actions_.size(); }
+    const std::vector<int32_t>& actions() const { return actions_; }
+    const std::vector<uint32_t>& checksums() const { return checksums_; }
+
+    // The game after position() steps
+    TetrisGame& game() { return *game_; }
+    size_t position() const { return position_; }
+
+    void rewind();
+    // Applies the next action; false at the end of the log
+    bool step();
+    // Moves to the state after `steps` steps, replaying forward (rewinding first if needed)
+    bool seek(size_t steps);
+    // Replays the whole log; the index of the first step whose checksum
+    // does not match, or -1 if none
+    int64_t verify();
+
+private:
+    EpisodeLog::Header header_;
+    GameState start_;
+    std::unique_ptr<TetrisGame> game_;
+    std::vector<int32_t> actions_;
+    std::vector<uint32_t> checksums_;
+    size_t position_ = 0;
+};
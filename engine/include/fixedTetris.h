@@ -0,0 +1,227 @@
+#pragma once
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+#include "boardRules.h"
+#include "pieceSource.h"
+#include "pieceTables.h"
+#include "stepRules.h"
+#include "tetrisGame.h"
+
+// TetrisGame's rules (BoardRules/StepRules) on a board whose size and queue
+// length are template parameters, with the observation W columns wide and
+// no padding. FixedTetris<10, 20, 3> plays exactly like
+// TetrisGame(SIMULATION, 3, seed, randomizer); other sizes spawn at
+// (min(W / 2, W - 4), H - 1) with four rows of headroom above the H rows
+// that can clear.
+//
+// Only step()/reset() and the observation are provided: placements,
+// features, snapshots and everything built on them stay on TetrisGame.
+template <int W, int H, int Q>
+class FixedTetris {
+public:
+    static constexpr int Width = W;
+    static constexpr int Height = H;                     // rows that can clear
+    static constexpr int Rows = H + Tetris::PIECE_SIZE;  // plus spawn headroom
+    static constexpr int QueueSize = Q;
+    static constexpr int SpawnX = W / 2 < W - Tetris::PIECE_SIZE ? W / 2 : W - Tetris::PIECE_SIZE;
+    static constexpr int SpawnY = H - 1;
+
+    // Same row encoding as TetrisGame
+    using Rules = BoardRules<W, Rows, H>;
+    static constexpr int BoardWall = Rules::Wall;
+    static constexpr uint16_t FullRow = Rules::FullRow;
+    static constexpr uint16_t EmptyRow = Rules::EmptyRow;
+
+    // Observation planes back to back: active_tetromino and board (Rows x W
+    // each), holder (4 x 4), queue (Q * 4 x 4)
+    static constexpr int PieceCells = Tetris::PIECE_SIZE * Tetris::PIECE_SIZE;
+    static constexpr size_t ObsSize = 2 * static_cast<size_t>(Rows) * W + static_cast<size_t>(1 + Q) * PieceCells;
+
+    static_assert(Q >= 1 && Q <= 255, "queue_size is a uint8_t");
+
+    explicit FixedTetris(uint32_t seed = 0, PieceRandomizer randomizer = PieceRandomizer::UNIFORM);
+
+    void reset();
+    // One action followed by one gravity tick, like TetrisGame::step
+    StepResult step(int action);
+    bool isGameOver() const { return game_over; }
+
+    // x in [0, W), y in [0, Rows); out of range is ignored / reads as empty
+    void setCell(int x, int y, uint8_t value);
+    uint8_t getCell(int x, int y) const;
+    int getGhostY() const;
+    // Writes ObsSize bytes in the plane order above
+    void writeObservation(uint8_t* dest) const;
+
+    PieceSource pieces;
+    uint16_t board_rows[Rows];
+    uint8_t board_cells[Rows][W];  // piece_type + 1, 0 = empty
+    uint8_t column_heights[W];
+    uint8_t queue[Q];
+    uint8_t queue_index;
+    uint8_t holder_type;
+    int8_t current_x;
+    int8_t current_y;
+    uint8_t current_piece_type;
+    uint8_t rotation;
+    int score;
+    int scored;  // lines cleared by the last step
+    bool game_over;
+
+private:
+    friend struct StepRules;
+    static int spawnX(uint8_t) { return SpawnX; }
+    static int spawnY(uint8_t) { return SpawnY; }
+    uint8_t getNextPiece();
+    void lockPiece();
+    int clearLines();
+    void completeClearLines();
+
+    // Rows the last lock filled, removed by completeClearLines
+    int8_t clearing_y;
+    uint8_t clearing_rows;
+};
+
+template <int W, int H, int Q>
+FixedTetris<W, H, Q>::FixedTetris(uint32_t seed, PieceRandomizer randomizer) : pieces(seed, randomizer) {
+    if (randomizer == PieceRandomizer::COMPAT) {
+        throw std::invalid_argument("COMPAT pieces are only available on TetrisGame");
+    }
+    reset();
+}
+
+template <int W, int H, int Q>
+void FixedTetris<W, H, Q>::reset() {
+    std::fill_n(board_rows, Rows, EmptyRow);
+    std::memset(board_cells, 0, sizeof(board_cells));
+    std::memset(column_heights, 0, sizeof(column_heights));
+    score = 0;
+    scored = 0;
+    game_over = false;
+    holder_type = 7;
+
+    for (int i = 0; i < Q; i++) {
+        queue[i] = pieces.next();
+    }
+    queue_index = 0;
+    clearing_y = 0;
+    clearing_rows = 0;
+
+    StepRules::spawnPiece(*this);
+    if (StepRules::collides(*this, current_x, current_y, rotation)) {
+        game_over = true;
+    }
+}
+
+template <int W, int H, int Q>
+uint8_t FixedTetris<W, H, Q>::getNextPiece() {
+    const uint8_t next_piece = queue[queue_index];
+    queue[queue_index] = pieces.next();
+    queue_index = static_cast<uint8_t>((queue_index + 1) % Q);
+    return next_piece;
+}
+
+template <int W, int H, int Q>
+void FixedTetris<W, H, Q>::setCell(int x, int y, uint8_t value) {
+    Rules::setCell(board_rows, &board_cells[0][0], column_heights, x, y, value);
+}
+
+template <int W, int H, int Q>
+uint8_t FixedTetris<W, H, Q>::getCell(int x, int y) const {
+    if (x < 0 || x >= W || y < 0 || y >= Rows) {
+        return 0;
+    }
+    return board_cells[y][x];
+}
+
+template <int W, int H, int Q>
+int FixedTetris<W, H, Q>::getGhostY() const {
+    return Rules::landingY(board_rows, column_heights, current_piece_type, current_x, current_y, rotation);
+}
+
+template <int W, int H, int Q>
+void FixedTetris<W, H, Q>::lockPiece() {
+    Rules::lockPiece(board_rows, &board_cells[0][0], column_heights, current_piece_type, current_x, current_y,
+                     rotation);
+}
+
+template <int W, int H, int Q>
+int FixedTetris<W, H, Q>::clearLines() {
+    clearing_y = current_y;
+    clearing_rows = static_cast<uint8_t>(Rules::fullRows(board_rows, current_y));
+    return __builtin_popcount(clearing_rows);
+}
+
+template <int W, int H, int Q>
+void FixedTetris<W, H, Q>::completeClearLines() {
+    Rules::clearRows(board_rows, &board_cells[0][0], column_heights, clearing_y, clearing_rows);
+    clearing_rows = 0;
+}
+
+template <int W, int H, int Q>
+StepResult FixedTetris<W, H, Q>::step(int action) {
+    return StepRules::step(*this, action);
+}
+
+namespace FixedTetrisDetail {
+
+// Rotation-0 4x4 grid of each piece, as drawn into the holder/queue planes
+struct PieceGrids {
+    uint8_t cells[Tetris::NUM_PIECES][Tetris::PIECE_SIZE * Tetris::PIECE_SIZE];
+};
+
+constexpr PieceGrids makePieceGrids() {
+    PieceGrids grids{};
+    for (int p = 0; p < Tetris::NUM_PIECES; p++) {
+        for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
+            for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
+                grids.cells[p][y * Tetris::PIECE_SIZE + x] = (Tetris::PIECE_TABLE.shapes[p][0].rows[y] >> x) & 1;
+            }
+        }
+    }
+    return grids;
+}
+
+constexpr PieceGrids PIECE_GRIDS = makePieceGrids();
+
+}  // namespace FixedTetrisDetail
+
+template <int W, int H, int Q>
+void FixedTetris<W, H, Q>::writeObservation(uint8_t* dest) const {
+    uint8_t* active = dest;
+    uint8_t* board = dest + Rows * W;
+    uint8_t* holder = dest + 2 * Rows * W;
+    uint8_t* next = holder + PieceCells;
+
+    std::memset(active, 0, Rows * W);
+    const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[current_piece_type][rotation];
+    for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+        const int board_y = current_y + shape.cell_y[i];
+        const int board_x = current_x + shape.cell_x[i];
+        if (board_y >= 0 && board_y < Rows && board_x >= 0 && board_x < W) {
+            active[board_y * W + board_x] = 1;
+        }
+    }
+    std::memcpy(board, board_cells, sizeof(board_cells));
+
+    if (holder_type < 7) {
+        std::memcpy(holder, FixedTetrisDetail::PIECE_GRIDS.cells[holder_type], PieceCells);
+    } else {
+        std::memset(holder, 0, PieceCells);
+    }
+    for (int i = 0; i < Q; i++) {
+        std::memcpy(next + i * PieceCells, FixedTetrisDetail::PIECE_GRIDS.cells[queue[(queue_index + i) % Q]],
+                    PieceCells);
+    }
+}
+
+// The sizes exposed to Python, compiled once in fixedTetris.cpp
+using Tetris10x20 = FixedTetris<10, 20, 3>;  // standard
+using Tetris6x12 = FixedTetris<6, 12, 3>;    // mini, for curriculum
+using Tetris10x40 = FixedTetris<10, 40, 3>;  // tall
+
+extern template class FixedTetris<10, 20, 3>;
+extern template class FixedTetris<6, 12, 3>;
+extern template class FixedTetris<10, 40, 3>;
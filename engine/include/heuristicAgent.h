@@ -0,0 +1,43 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "planner.h"
+#include "tetrisGame.h"
+
+// One-ply placement agent: scores every afterstate of the current piece
+// with a weighted feature sum (LinearValue over the afterstate row, plus
+// landing height, which only the placement knows) and plays the best.
+// With the defaults this is El-Tetris, a tuned Dellacherie evaluator.
+class HeuristicAgent {
+public:
+    static constexpr float ElTetrisLandingHeight = -4.5001588f;
+
+    struct GameStats {
+        uint32_t pieces;
+        uint32_t lines;
+        bool topped_out;
+    };
+
+    explicit HeuristicAgent(const LinearValue& value = LinearValue::elTetris(),
+                            float landing_height_weight = ElTetrisLandingHeight,
+                            bool use_hold = false);
+
+    // Enumerates game's placements and returns the index of the best one
+    // (for game.stepPlacement), or -1 if there is none
+    int choose(TetrisGame& game);
+    // One score per placement, higher is better. Features are laid out one
+    // column per weighted term so the weighted sum runs down contiguous floats.
+    void scorePlacements(const std::vector<Placement>& placements, float* scores);
+    // Plays until game over or max_pieces placements
+    GameStats play(TetrisGame& game, uint32_t max_pieces);
+
+    bool use_hold() const { return use_hold_; }
+
+private:
+    std::vector<int> terms_;        // afterstate columns with a non-zero weight
+    std::vector<float> term_weights_;
+    float landing_height_weight_;
+    bool use_hold_;
+    std::vector<float> columns_;    // [term][placement]
+    std::vector<float> scores_;
+};
@@ -0,0 +1,24 @@
+#pragma once
+
+#include <cstddef>
+#include <vector>
+
+// Thread pinning and huge-page allocations for the collector's hot data.
+// Everything here is best effort: where the OS (or a container) refuses,
+// callers carry on with unpinned threads and ordinary pages.
+
+// Per-thread state is padded to this so neighbours never share a line
+constexpr size_t CacheLineSize = 64;
+
+// CPUs this process may run on, ascending. Falls back to 0..n-1 for the
+// hardware concurrency where the affinity mask can't be read.
+std::vector<int> allowedCpus();
+
+// Restricts the calling thread to one CPU. Memory the thread touches first
+// afterwards is then placed on that CPU's NUMA node.
+bool pinCurrentThread(int cpu);
+
+// bytes of zero-initialized memory aligned to and advised for 2 MiB huge
+// pages; nullptr if that fails. Release with freeHugePages(ptr, bytes).
+void* allocateHugePages(size_t bytes);
+void freeHugePages(void* ptr, size_t bytes);
@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "pieceRng.h"
+
+// Native forward pass of rl/src/models/actor_critic.py: tanh hidden layers
+// shared by an actor head (action logits) and a critic head (one value).
+// Weights are copied in at construction and never change, so one policy can
+// be shared by every worker; to update the weights, build a new one.
+class MlpPolicy {
+public:
+    // torch.nn.Linear layout: weights[o * inputs + i]
+    struct Layer {
+        size_t inputs = 0;
+        size_t outputs = 0;
+        std::vector<float> weights;
+        std::vector<float> bias;
+    };
+
+    // Activations for one thread's forward passes; grows on first use
+    struct Scratch {
+        std::vector<float> a;
+        std::vector<float> b;
+        std::vector<float> logits;
+        std::vector<float> values;
+    };
+
+    struct Sample {
+        int action;
+        float log_prob;
+        float value;
+    };
+
+    // hidden layers run in order, each followed by tanh; actor and critic
+    // read the last one's output. Throws std::invalid_argument if the
+    // shapes don't chain or the critic has more than one output.
+    MlpPolicy(std::vector<Layer> hidden, Layer actor, Layer critic);
+
+    size_t inputSize() const { return hidden_.empty() ? actor_.inputs : hidden_.front().inputs; }
+    size_t numActions() const { return actor_.outputs; }
+
+    // obs [rows, inputSize()] -> logits [rows, numActions()], values [rows]
+    void forward(const float* obs, size_t rows, float* logits, float* values, Scratch& scratch) const;
+
+    // forward, then an action drawn from softmax(logits) per row, row r
+    // using *rngs[r]; out gets the action, its log-probability and the value
+    void act(const float* obs, size_t rows, PieceRng* const* rngs, Sample* out, Scratch& scratch) const;
+
+private:
+    // out[r] = in[r] . W^T + b for each of rows rows, then tanh if asked
+    static void dense(const Layer& layer, const float* in, size_t rows, float* out, bool apply_tanh);
+    Sample sample(const float* logits, float value, PieceRng& rng) const;
+
+    std::vector<Layer> hidden_;
+    Layer actor_;
+    Layer critic_;
+    size_t max_width_ = 0;
+};
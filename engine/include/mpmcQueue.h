@@ -0,0 +1,182 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+// Bounded multi-producer multi-consumer ring buffer (Vyukov's sequence
+// per cell). tryPush/tryPop never block or lock. push/pop spin briefly,
+// yield a few times, then park on a condition variable that is only
+// touched when someone is actually parked, so the uncontended path stays
+// free of futex calls.
+template <typename T>
+class MpmcQueue {
+public:
+    // capacity is rounded up to a power of two
+    explicit MpmcQueue(size_t capacity) {
+        size_t size = 2;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        mask_ = size - 1;
+        cells_ = std::make_unique<Cell[]>(size);
+        for (size_t i = 0; i < size; i++) {
+            cells_[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+    MpmcQueue(const MpmcQueue&) = delete;
+    MpmcQueue& operator=(const MpmcQueue&) = delete;
+
+    size_t capacity() const { return mask_ + 1; }
+
+    bool tryPush(const T& value) {
+        size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+            if (diff == 0) {
+                if (enqueue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(pos + 1, std::memory_order_release);
+                    wakeParked();
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // full
+            } else {
+                pos = enqueue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    bool tryPop(T& out) {
+        size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+        while (true) {
+            Cell& cell = cells_[pos & mask_];
+            const size_t sequence = cell.sequence.load(std::memory_order_acquire);
+            const intptr_t diff = static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1);
+            if (diff == 0) {
+                if (dequeue_pos_.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed)) {
+                    out = cell.value;
+                    cell.sequence.store(pos + mask_ + 1, std::memory_order_release);
+                    wakeParked();
+                    return true;
+                }
+            } else if (diff < 0) {
+                return false;  // empty
+            } else {
+                pos = dequeue_pos_.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    // Waits for space; false if the queue was closed while full
+    bool push(const T& value) {
+        return wait([&] { return tryPush(value); });
+    }
+
+    // Waits for an element; false once the queue is closed and drained
+    bool pop(T& out) {
+        return wait([&] { return tryPop(out); });
+    }
+
+    // Wakes every waiter; from now on push/pop only try once instead of waiting
+    void close() {
+        {
+            std::lock_guard<std::mutex> lock(park_mutex_);
+            closed_.store(true);
+        }
+        park_cv_.notify_all();
+    }
+
+    void reopen() { closed_.store(false); }
+    bool closed() const { return closed_.load(); }
+
+private:
+    static constexpr int SpinIterations = 64;
+    static constexpr int YieldIterations = 16;
+
+    struct alignas(64) Cell {
+        std::atomic<size_t> sequence{0};
+        T value{};
+    };
+
+    static void cpuRelax() {
+#if defined(__SSE2__) || defined(_M_X64)
+        _mm_pause();
+#else
+        std::this_thread::yield();
+#endif
+    }
+
+    template <typename Attempt>
+    bool wait(Attempt attempt) {
+        for (int i = 0; i < SpinIterations; i++) {
+            if (attempt()) {
+                return true;
+            }
+            if (closed_.load(std::memory_order_relaxed)) {
+                return attempt();
+            }
+            cpuRelax();
+        }
+        // Give the other side a chance to run before paying for a futex,
+        // which matters most when threads outnumber cores
+        for (int i = 0; i < YieldIterations; i++) {
+            std::this_thread::yield();
+            if (attempt()) {
+                return true;
+            }
+            if (closed_.load(std::memory_order_relaxed)) {
+                return attempt();
+            }
+        }
+        while (true) {
+            // Register, then retry: an operation that lands after the retry
+            // sees parked_ > 0 and bumps epoch_, so the wait below returns
+            parked_.fetch_add(1, std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_seq_cst);
+            const uint64_t seen = epoch_.load(std::memory_order_relaxed);
+            const bool done = attempt();
+            if (done || closed_.load()) {
+                parked_.fetch_sub(1, std::memory_order_relaxed);
+                return done || attempt();
+            }
+            {
+                std::unique_lock<std::mutex> lock(park_mutex_);
+                park_cv_.wait(lock, [&] { return epoch_.load(std::memory_order_relaxed) != seen || closed_.load(); });
+            }
+            parked_.fetch_sub(1, std::memory_order_relaxed);
+        }
+    }
+
+    void wakeParked() {
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (parked_.load(std::memory_order_relaxed) > 0) {
+            {
+                std::lock_guard<std::mutex> lock(park_mutex_);
+                epoch_.fetch_add(1, std::memory_order_relaxed);
+            }
+            park_cv_.notify_all();
+        }
+    }
+
+    std::unique_ptr<Cell[]> cells_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> enqueue_pos_{0};
+    alignas(64) std::atomic<size_t> dequeue_pos_{0};
+    alignas(64) std::atomic<int> parked_{0};
+    std::atomic<uint64_t> epoch_{0};
+    std::atomic<bool> closed_{false};
+    std::mutex park_mutex_;
+    std::condition_variable park_cv_;
+};
@@ -0,0 +1,35 @@
+#pragma once
+#include <cstdint>
+
+// Random bit generator for piece sampling: PCG32 (XSH-RR variant).
+// 16 bytes of state, so it can be copied inside a GameState snapshot
+// where a std::mt19937 would cost 5 KB. Satisfies UniformRandomBitGenerator.
+class PieceRng {
+public:
+    using result_type = uint32_t;
+
+    PieceRng() : PieceRng(0) {}
+    explicit PieceRng(uint64_t seed) : state(0), inc((Stream << 1u) | 1u) {
+        (*this)();
+        state += seed;
+        (*this)();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return UINT32_MAX; }
+
+    result_type operator()() {
+        const uint64_t old = state;
+        state = old * Multiplier + inc;
+        const uint32_t xorshifted = static_cast<uint32_t>(((old >> 18u) ^ old) >> 27u);
+        const uint32_t rot = static_cast<uint32_t>(old >> 59u);
+        return (xorshifted >> rot) | (xorshifted << ((32u - rot) & 31u));
+    }
+
+    uint64_t state;
+    uint64_t inc;
+
+private:
+    static constexpr uint64_t Multiplier = 6364136223846793005ULL;
+    static constexpr uint64_t Stream = 0xda3e39cb94b95bdbULL;
+};
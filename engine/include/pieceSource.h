@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include "pieceRng.h"
+
+// How the piece sequence is drawn. UNIFORM and BAG7 come from PieceRng,
+// so a seed gives different pieces than it did with the old per-game
+// std::mt19937. COMPAT keeps those old sequences; it is drawn by
+// TetrisGame itself (see TetrisGame::compat_rng), not by PieceSource.
+enum class PieceRandomizer : uint8_t {
+    UNIFORM,  // independent uniform pieces
+    BAG7,     // every 7 pieces are a shuffled bag of all seven
+    COMPAT    // std::uniform_int_distribution over std::mt19937(seed), as
+              // before PieceSource. TetrisGame only, no snapshots
+};
+
+// Per-game piece generator. Pieces are generated a block at a time, so
+// next() is a ring-buffer read except once per block. Plain bytes like
+// PieceRng, so it travels inside a GameState snapshot.
+struct PieceSource {
+    static constexpr int NumPieces = 7;
+    static constexpr int BlockSize = 16;
+
+    PieceSource() : PieceSource(0) {}
+    explicit PieceSource(uint64_t seed, PieceRandomizer randomizer = PieceRandomizer::UNIFORM)
+        : rng(seed), block{}, pos(0), len(0), randomizer(randomizer) {}
+
+    uint8_t next() {
+        if (pos >= len) {
+            refill();
+        }
+        return block[pos++];
+    }
+
+    // Restarts the sequence from seed, discarding pieces already generated
+    void reseed(uint64_t seed) {
+        rng = PieceRng(seed);
+        pos = len = 0;
+    }
+
+    PieceRng rng;
+    uint8_t block[BlockSize];
+    uint8_t pos;
+    uint8_t len;
+    PieceRandomizer randomizer;
+
+private:
+    void refill() {
+        pos = 0;
+        switch (randomizer) {
+        case PieceRandomizer::UNIFORM:
+            // Multiply-shift range reduction, four pieces per 32-bit draw:
+            // each step's high word is the piece, its low word feeds the next
+            for (int i = 0; i < BlockSize; i += 4) {
+                uint32_t bits = rng();
+                for (int k = 0; k < 4; k++) {
+                    const uint64_t m = static_cast<uint64_t>(bits) * NumPieces;
+                    block[i + k] = static_cast<uint8_t>(m >> 32);
+                    bits = static_cast<uint32_t>(m);
+                }
+            }
+            len = BlockSize;
+            break;
+        case PieceRandomizer::BAG7:
+        default:
+            // Two bags, each a Fisher-Yates shuffle
+            for (int bag = 0; bag < 2; bag++) {
+                uint8_t* pieces = block + bag * NumPieces;
+                for (int i = 0; i < NumPieces; i++) {
+                    pieces[i] = static_cast<uint8_t>(i);
+                }
+                for (int i = NumPieces - 1; i > 0; i--) {
+                    const int j = static_cast<int>((static_cast<uint64_t>(rng()) * (i + 1)) >> 32);
+                    const uint8_t tmp = pieces[i];
+                    pieces[i] = pieces[j];
+                    pieces[j] = tmp;
+                }
+            }
+            len = 2 * NumPieces;
+            break;
+        }
+    }
+};
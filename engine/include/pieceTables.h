@@ -0,0 +1,115 @@
+#pragma once
+#include <cstdint>
+#include "constants.h"
+#include "pieces.h"
+
+namespace Tetris {
+    constexpr int NUM_PIECES = 7;
+    constexpr int NUM_ROTATIONS = 4;
+    constexpr int PIECE_CELLS = 4;
+
+    // Precomputed geometry for one piece rotation.
+    // rows[y] has bit x set when PIECES[..][y][x] is filled.
+    struct PieceShape {
+        uint8_t rows[PIECE_SIZE];
+        int8_t min_x, max_x;  // bounding box of the filled cells (inclusive)
+        int8_t min_y, max_y;
+        int8_t cell_x[PIECE_CELLS];  // filled cells in row-major order
+        int8_t cell_y[PIECE_CELLS];
+        uint8_t cell_count;
+        // Lowest filled row of each column, PIECE_SIZE for empty columns
+        int8_t col_bottom[PIECE_SIZE];
+    };
+
+    struct PieceTable {
+        PieceShape shapes[NUM_PIECES][NUM_ROTATIONS];
+        // Spawn position of each piece in board coordinates
+        int8_t spawn_x[NUM_PIECES];
+        int8_t spawn_y[NUM_PIECES];
+    };
+
+    constexpr PieceShape makePieceShape(int piece, int rotation) {
+        PieceShape shape{};
+        shape.min_x = PIECE_SIZE;
+        shape.min_y = PIECE_SIZE;
+        shape.max_x = -1;
+        shape.max_y = -1;
+        for (int x = 0; x < PIECE_SIZE; x++) {
+            shape.col_bottom[x] = PIECE_SIZE;
+        }
+        for (int y = 0; y < PIECE_SIZE; y++) {
+            for (int x = 0; x < PIECE_SIZE; x++) {
+                if (!PIECES[piece][rotation][y][x]) {
+                    continue;
+                }
+                shape.rows[y] |= static_cast<uint8_t>(1u << x);
+                if (x < shape.min_x) shape.min_x = x;
+                if (x > shape.max_x) shape.max_x = x;
+                if (y < shape.min_y) shape.min_y = y;
+                if (y > shape.max_y) shape.max_y = y;
+                if (y < shape.col_bottom[x]) shape.col_bottom[x] = y;
+                if (shape.cell_count < PIECE_CELLS) {
+                    shape.cell_x[shape.cell_count] = x;
+                    shape.cell_y[shape.cell_count] = y;
+                }
+                shape.cell_count++;
+            }
+        }
+        return shape;
+    }
+
+    constexpr PieceTable makePieceTable() {
+        PieceTable table{};
+        for (int p = 0; p < NUM_PIECES; p++) {
+            for (int r = 0; r < NUM_ROTATIONS; r++) {
+                table.shapes[p][r] = makePieceShape(p, r);
+            }
+            table.spawn_x[p] = BOARD_WIDTH / 2;
+            table.spawn_y[p] = BOARD_HEIGHT - 1;
+        }
+        return table;
+    }
+
+    constexpr PieceTable PIECE_TABLE = makePieceTable();
+
+    // Lowest y at which the piece rests on a surface of column heights
+    // (height = 1 + topmost filled row, 0 when empty) when dropped at x.
+    // Only valid when the piece starts above the surface.
+    constexpr int surfaceLandingY(const PieceShape& shape, const uint8_t* heights, int x) {
+        int landing = -shape.min_y;
+        for (int c = shape.min_x; c <= shape.max_x; c++) {
+            const int rest = heights[x + c] - shape.col_bottom[c];
+            if (rest > landing) landing = rest;
+        }
+        return landing;
+    }
+
+    constexpr bool pieceTableIsValid() {
+        for (int p = 0; p < NUM_PIECES; p++) {
+            for (int r = 0; r < NUM_ROTATIONS; r++) {
+                const PieceShape& s = PIECE_TABLE.shapes[p][r];
+                if (s.cell_count != PIECE_CELLS) return false;
+                if (s.min_x < 0 || s.max_x >= PIECE_SIZE || s.min_x > s.max_x) return false;
+                if (s.min_y < 0 || s.max_y >= PIECE_SIZE || s.min_y > s.max_y) return false;
+                // Every column in the bounding box holds a cell (all pieces are
+                // connected), which surfaceLandingY relies on
+                for (int x = s.min_x; x <= s.max_x; x++) {
+                    if (s.col_bottom[x] >= PIECE_SIZE) return false;
+                }
+                // Rows outside the bounding box must be empty
+                for (int y = 0; y < PIECE_SIZE; y++) {
+                    if ((y < s.min_y || y > s.max_y) && s.rows[y]) return false;
+                }
+            }
+            // Spawned pieces must be fully inside the playable width
+            if (PIECE_TABLE.spawn_x[p] + PIECE_TABLE.shapes[p][0].min_x < 0) return false;
+            if (PIECE_TABLE.spawn_x[p] + PIECE_TABLE.shapes[p][0].max_x >= BOARD_WIDTH) return false;
+        }
+        return true;
+    }
+
+    static_assert(pieceTableIsValid(), "every piece rotation must have 4 cells inside its 4x4 box");
+    static_assert(PIECE_TABLE.shapes[0][0].rows[1] == 0xF, "I-piece rot 0 is a full row");
+    static_assert(PIECE_TABLE.shapes[1][0].min_x == 1 && PIECE_TABLE.shapes[1][0].max_x == 2,
+                  "O-piece occupies columns 1-2");
+}
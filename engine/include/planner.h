@@ -0,0 +1,134 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <vector>
+
+#include "tetrisGame.h"
+#include "workerPool.h"
+
+// Linear leaf evaluator over afterstate rows (TetrisGame::writeAfterstate).
+// The defaults are the El-Tetris weights for the terms we track (landing
+// height has no afterstate column).
+struct LinearValue {
+    std::array<float, TetrisGame::AfterstateSize> weights{};
+
+    static LinearValue elTetris();
+    float operator()(const float* afterstate) const;
+};
+
+struct PlannerConfig {
+    enum Algorithm : uint8_t { BEAM, MCTS };
+
+    Algorithm algorithm = BEAM;
+    size_t num_threads = 0;       // 0 = hardware concurrency
+    int depth = 3;                // pieces searched ahead (root placement included)
+    bool use_hold = true;
+    float discount = 0.95f;
+    float terminal_value = -500.0f; // value of a topped-out afterstate
+    uint64_t seed = 0;            // for the pieces sampled past the visible queue
+    // BEAM
+    int beam_width = 32;
+    // MCTS (root-parallel: each thread grows its own tree, visits are summed)
+    int simulations = 512;
+    float exploration = 0.05f;   // UCT constant, Q is min-max normalised to [0, 1]
+};
+
+struct PlanResult {
+    int32_t placement = -1;       // index into root enumeratePlacements(use_hold), -1 if none
+    float value = 0.0f;           // estimated return of that placement
+    uint64_t pieces_simulated = 0;
+    std::vector<float> root_scores; // per root placement: beam score or MCTS visit count
+};
+
+// Beam search / MCTS over placements. Every expansion runs on native
+// TetrisGame copies restored from GameState snapshots; only the optional
+// value callback leaves C++. The root's RNG is reseeded before searching,
+// so lookahead past the visible queue sees fresh random pieces rather than
+// the game's actual future.
+class TetrisPlanner {
+public:
+    // Called with `count` afterstate rows of TetrisGame::AfterstateSize
+    // floats; writes one value per row. May be called from several threads.
+    using ValueFn = std::function<void(const float* afterstates, size_t count, float* values)>;
+
+    explicit TetrisPlanner(const PlannerConfig& config, uint8_t queue_size = 3);
+
+    TetrisPlanner(const TetrisPlanner&) = delete;
+    TetrisPlanner& operator=(const TetrisPlanner&) = delete;
+
+    // Empty fn restores the built-in LinearValue
+    void setValueFn(ValueFn fn);
+    void setLinearValue(const LinearValue& value) { linear_ = value; }
+    const PlannerConfig& config() const { return config_; }
+
+    PlanResult plan(const GameState& root);
+
+private:
+    struct Child {
+        GameState state;
+        float reward;
+        bool terminal;
+    };
+
+    struct Candidate {
+        GameState state;
+        float ret;          // discounted reward collected so far
+        float score;        // ret + discounted leaf value
+        int32_t root_action;
+        int32_t row;        // afterstate row awaiting evaluation, -1 if none
+        bool terminal;
+    };
+
+    struct MctsNode {
+        GameState state;
+        float reward;       // lines cleared by the placement leading here
+        float value;        // evaluator estimate of this afterstate
+        float value_sum;
+        uint32_t visits;
+        uint32_t first_child;
+        uint16_t num_children;
+        uint16_t action;
+        bool expanded;
+        bool terminal;
+    };
+
+    struct WorkerScratch {
+        std::unique_ptr<TetrisGame> game;
+        std::vector<Placement> placements;
+        std::vector<Child> children;
+        std::vector<Candidate> candidates;
+        std::vector<float> rows;
+        std::vector<float> values;
+        std::vector<MctsNode> tree;
+        std::vector<uint32_t> path;
+        float q_min = 0.0f;
+        float q_max = 0.0f;
+        uint64_t pieces = 0;
+    };
+
+    PlanResult planBeam(const GameState& root);
+    PlanResult planMcts(const GameState& root);
+    void expandBeam(WorkerScratch& worker, const Candidate& node, int depth);
+    void runMcts(WorkerScratch& worker, const GameState& root, int simulations);
+    void expandMcts(WorkerScratch& worker, uint32_t node_index);
+    // Plays every placement from state into worker.children and appends
+    // their afterstate rows to worker.rows
+    size_t expandChildren(WorkerScratch& worker, const GameState& state);
+    void evaluate(const float* rows, size_t count, float* values) const;
+
+    PlannerConfig config_;
+    uint8_t queue_size_;
+    LinearValue linear_;
+    ValueFn value_fn_;
+    std::vector<WorkerScratch> workers_;
+    uint64_t plan_count_ = 0;
+    std::vector<Candidate> beam_;
+    std::vector<Candidate> next_;
+    std::vector<float> rows_;
+    std::vector<float> values_;
+    // Last, so its threads stop before the scratch they use goes away
+    WorkerPool pool_;
+};
@@ -0,0 +1,135 @@
+#pragma once
+#include <cstdint>
+#include <utility>
+#include "tetrisGame.h"
+
+// The step half of the game rules: what an action, a gravity tick, a lock
+// and a hold do, shared by TetrisGame, FixedTetris and VecTetris (through
+// a per-env view). A Game provides
+//   Rules                               its BoardRules
+//   board_rows                          the rows Rules::collides reads
+//   current_x, current_y, rotation, current_piece_type, holder_type,
+//   score, scored, game_over            plain fields
+//   static spawnX(type), spawnY(type)   spawn position
+//   getNextPiece()                      pops the queue
+//   getGhostY()                         current piece's hard-drop landing
+//   lockPiece()                         writes the current piece
+//   clearLines()                        counts the full rows it made and
+//                                       queues them for removal
+//   completeClearLines()                removes the queued rows
+struct StepRules {
+    template <class Game>
+    static bool collides(const Game& g, int x, int y, uint8_t rot) {
+        return Game::Rules::collides(&g.board_rows[0], g.current_piece_type, x, y, rot);
+    }
+
+    template <class Game>
+    static void moveToSpawn(Game& g) {
+        g.current_x = static_cast<int8_t>(Game::spawnX(g.current_piece_type));
+        g.current_y = static_cast<int8_t>(Game::spawnY(g.current_piece_type));
+        g.rotation = 0;
+    }
+
+    template <class Game>
+    static void spawnPiece(Game& g) {
+        g.current_piece_type = g.getNextPiece();
+        moveToSpawn(g);
+    }
+
+    // Locks the current piece and scores the rows it filled, then spawns the
+    // next piece (game over if it collides) while those rows are still on
+    // the board. completeClearLines() removes them.
+    template <class Game>
+    static void lockAndSpawn(Game& g) {
+        g.lockPiece();
+        const int lines = g.clearLines();
+        g.scored += lines;
+        g.score += lines;
+        spawnPiece(g);
+        if (collides(g, g.current_x, g.current_y, g.rotation)) {
+            g.game_over = true;
+        }
+    }
+
+    // Holds the current piece and brings in the held one (or the next one
+    // while the holder is empty) at the spawn position
+    template <class Game>
+    static void swapHold(Game& g) {
+        if (g.holder_type == 7) {
+            g.holder_type = g.current_piece_type;
+            g.current_piece_type = g.getNextPiece();
+        } else {
+            std::swap(g.current_piece_type, g.holder_type);
+        }
+        moveToSpawn(g);
+        if (collides(g, g.current_x, g.current_y, g.rotation)) {
+            g.game_over = true;
+        }
+    }
+
+    // Where LEFT..CCW would move the piece from (x, y, rot). False for
+    // DROP, SWAP and NOOP, which are not moves.
+    static bool moveTarget(uint8_t action, int& x, int& y, uint8_t& rot) {
+        switch (action) {
+            case Action::LEFT:
+                x -= 1;
+                return true;
+            case Action::RIGHT:
+                x += 1;
+                return true;
+            case Action::DOWN:
+                y -= 1;
+                return true;
+            case Action::CW:
+                rot = static_cast<uint8_t>((rot + 1) % 4);
+                return true;
+            case Action::CCW:
+                rot = static_cast<uint8_t>((rot + 3) % 4);
+                return true;
+            default:
+                return false;
+        }
+    }
+
+    // A move is dropped if it collides; DROP locks at the landing row
+    template <class Game>
+    static void applyAction(Game& g, uint8_t action) {
+        int x = g.current_x;
+        int y = g.current_y;
+        uint8_t rot = g.rotation;
+        if (moveTarget(action, x, y, rot)) {
+            if (!collides(g, x, y, rot)) {
+                g.current_x = static_cast<int8_t>(x);
+                g.current_y = static_cast<int8_t>(y);
+                g.rotation = rot;
+            }
+        } else if (action == Action::DROP) {
+            g.current_y = static_cast<int8_t>(g.getGhostY());
+            lockAndSpawn(g);
+        } else if (action == Action::SWAP) {
+            swapHold(g);
+        }
+    }
+
+    // One row down, or lock if the piece is resting
+    template <class Game>
+    static void applyGravity(Game& g) {
+        if (collides(g, g.current_x, g.current_y - 1, g.rotation)) {
+            lockAndSpawn(g);
+        } else {
+            g.current_y -= 1;
+        }
+    }
+
+    // The action, then one gravity tick. Rows filled by a lock are gone
+    // before the next tick, and the reward is the lines cleared this step.
+    template <class Game>
+    static StepResult step(Game& g, int action) {
+        g.scored = 0;
+        applyAction(g, static_cast<uint8_t>(action));
+        g.completeClearLines();
+        applyGravity(g);
+        g.completeClearLines();
+        return StepResult{static_cast<float>(g.scored), static_cast<bool>(g.game_over)};
+    }
+};
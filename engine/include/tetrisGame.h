@@ -1,32 +1,161 @@
 #pragma once
 #include <vector>
+#include <memory>
 #include <cstdint>
 #include <random>
 #include "timeManager.h"
+#include "constants.h"
+#include "pieceSource.h"
+#include "boardRules.h"
 
 enum Action : uint8_t {
     LEFT, RIGHT, DOWN, CW, CCW, DROP, SWAP, NOOP
 };
 
+// Row-major 2D view into an Observation buffer
+template <typename T>
+struct GridView {
+    struct Row {
+        T* data;
+        int cols;
+        T& operator[](int x) const { return data[x]; }
+        size_t size() const { return static_cast<size_t>(cols); }
+    };
+
+    T* data = nullptr;
+    int rows = 0;
+    int cols = 0;
+
+    Row operator[](int y) const { return Row{data + static_cast<size_t>(y) * cols, cols}; }
+    size_t size() const { return static_cast<size_t>(rows); }
+};
+
 struct Observation {
     static constexpr int BoardW = 18;
     static constexpr int BoardH = 24;
-    
-    std::vector<std::vector<uint8_t>> board; // 0-9 representing all forms of tetrominoes
-    std::vector<std::vector<uint8_t>> active_tetromino; // 0,1 mask for where the piece is
-    std::vector<std::vector<uint8_t>> holder;
-    std::vector<std::vector<uint8_t>> queue;
+    static constexpr size_t Alignment = 64; // buffer starts on a cache line
+
+    explicit Observation(int queue_size = 3);
+    Observation(const Observation& other);
+    Observation(Observation&& other) noexcept;
+    Observation& operator=(const Observation& other);
+    Observation& operator=(Observation&& other) noexcept;
+
+    // All planes live back to back in one buffer, in flattening order:
+    // active_tetromino, board, holder, queue
+    const uint8_t* data() const { return buffer_.get(); }
+    size_t size() const { return size_; }
+
+    // Lossless bit-packed form of data(): the 0/1 planes (active_tetromino,
+    // then holder and queue) 8 cells per byte with the first cell in the
+    // low bit, the board's piece ids two cells per byte (low nibble first).
+    // Layout: active bits, board nibbles, holder + queue bits.
+    static size_t packedSize(int queue_size);
+    size_t pack(uint8_t* dest) const;
+    // Same for cells laid out like data(), e.g. VecTetris::renderObservation
+    static size_t pack(const uint8_t* cells, int queue_size, uint8_t* dest);
+    // Expands count packed observations back to data() cells as floats,
+    // writing count * size() floats
+    static void unpack(const uint8_t* src, size_t count, int queue_size, float* dest);
+
+    GridView<uint8_t> active_tetromino; // 0,1 mask for where the piece is
+    GridView<uint8_t> board; // 0-9 representing all forms of tetrominoes
+    GridView<uint8_t> holder;
+    GridView<uint8_t> queue;
+
+private:
+    struct AlignedDelete {
+        void operator()(uint8_t* ptr) const;
+    };
+
+    void allocate(int queue_rows);
+
+    std::unique_ptr<uint8_t[], AlignedDelete> buffer_;
+    size_t size_ = 0;
 };
 
+// Returned by value on every step, so it carries no observation;
+// read that through TetrisGame::getObservation() when needed.
 struct StepResult {
-    Observation obs;
     float reward;
     bool terminated;
 };
 
+// What the collector / Python env hand to the policy each step
+enum class ObsMode : uint8_t {
+    BOARD,    // the full Observation, flattened
+    FEATURES  // TetrisGame::writeFeatures, a few dozen floats
+};
+
+// How the collector stores BOARD observations
+enum class ObsDtype : uint8_t {
+    FLOAT32,  // one float per cell
+    UINT8,    // one byte per cell
+    PACKED    // Observation::pack, several cells per byte
+};
+
+// What an action means: an Action for step() or a placement index for
+// stepPlacement(). Also what one collector step asks of the policy.
+enum class ActionMode : uint8_t {
+    PRIMITIVE,  // policy_fn(obs) -> (action, log_prob, value)
+    PLACEMENT   // policy_fn(obs, afterstates) -> (placement index, log_prob, value)
+};
+
+// Hand-crafted board statistics over the visible rows, kept current by
+// TetrisGame as pieces lock and lines clear
+struct BoardFeatures {
+    uint8_t heights[Tetris::BOARD_WIDTH];
+    uint8_t holes[Tetris::BOARD_WIDTH];  // empty cells under the column's top
+    uint8_t wells[Tetris::BOARD_WIDTH];  // depth below the lower neighbour (walls are full height)
+    uint8_t column_transitions[Tetris::BOARD_WIDTH]; // filled/empty changes, floor counts as filled
+    int aggregate_height;
+    int max_height;
+    int total_holes;
+    int bumpiness;           // sum of |h[x] - h[x + 1]|
+    int row_transitions;     // filled/empty changes along rows, walls count as filled
+    int total_column_transitions;
+    int cumulative_wells;    // sum of 1 + 2 + ... + depth over the wells
+};
+
+// A reachable resting position for the current (or held) piece and what
+// the board looks like after it locks and its lines clear
+struct Placement {
+    int8_t x;
+    int8_t y;
+    uint8_t rotation;
+    uint8_t piece_type;
+    bool use_hold;          // SWAP first, then place the swapped-in piece
+    uint8_t lines_cleared;
+    BoardFeatures features; // of the resulting board
+};
+
+// Everything needed to resume a game, as plain bytes. Derived data (column
+// heights, features, the observation) is rebuilt by TetrisGame::restore,
+// so forking a game for search is a copy of these few cache lines.
+struct alignas(64) GameState {
+    static constexpr int MaxQueue = 8;
+
+    uint16_t board_rows[Observation::BoardH];
+    uint8_t board_cells[Observation::BoardH][Tetris::BOARD_WIDTH / 2]; // two cells per byte, low nibble = even x
+    PieceSource pieces;
+    int32_t score;
+    uint8_t queue[MaxQueue];
+    uint8_t queue_size;
+    uint8_t queue_index;
+    uint8_t holder_type;
+    int8_t current_x;
+    int8_t current_y;
+    uint8_t current_piece_type;
+    uint8_t rotation;
+    bool game_over;
+};
+
+static_assert(sizeof(GameState) <= 256, "GameState should stay within four cache lines");
+
 class TetrisGame {
 public:
-    TetrisGame(TimeManager::Mode m, uint8_t queue_size = 3, uint32_t seed = std::random_device{}());
+    TetrisGame(TimeManager::Mode m, uint8_t queue_size = 3, uint32_t seed = std::random_device{}(),
+               PieceRandomizer randomizer = PieceRandomizer::UNIFORM);
     void reset();
     StepResult step(int action);
     float getReward();
@@ -41,9 +170,70 @@ public:
     void loop();
 #endif
 
-    // for random sampling
-    uint8_t samplePiece();
-    std::mt19937 rng_;
+    uint8_t samplePiece() {
+        if (pieces.randomizer == PieceRandomizer::COMPAT) {
+            return static_cast<uint8_t>(std::uniform_int_distribution<int>(0, 6)(compat_rng));
+        }
+        return pieces.next();
+    }
+
+    // Direct board access (x in [0, BOARD_WIDTH), y in [0, BoardH)).
+    // Cells outside the playable width are ignored / read back as empty.
+    void setCell(int x, int y, uint8_t value);
+    uint8_t getCell(int x, int y) const;
+
+    // Surface height of each column (1 + topmost filled row, 0 if empty),
+    // kept up to date by locks, line clears and setCell.
+    const uint8_t* getColumnHeights() const { return column_heights; }
+    // Where the current piece lands if hard-dropped now (the ghost piece)
+    int getGhostY();
+
+    // Board features, refreshed only for the columns and rows changed
+    // since the last call
+    const BoardFeatures& getFeatures();
+    // Fixed-size float observation for ObsMode::FEATURES: heights, wells,
+    // the BoardFeatures totals, then one-hot current piece / rotation,
+    // x, y, and one-hot holder and queue pieces. Writes featureSize() floats.
+    size_t writeFeatures(float* dest);
+    size_t featureSize() const { return featureSize(queue_size); }
+    static size_t featureSize(int queue_size);
+    // The board part of writeFeatures (heights, wells, totals)
+    static constexpr int BoardFeatureCount = 2 * Tetris::BOARD_WIDTH + 7;
+    static size_t writeBoardFeatures(const BoardFeatures& f, float* dest);
+    // One afterstate row: lines cleared, then writeBoardFeatures of the result.
+    // The input to planner evaluators and the collector's PLACEMENT policy.
+    static constexpr int AfterstateSize = 1 + BoardFeatureCount;
+    static size_t writeAfterstate(const Placement& placement, float* dest);
+    // From-scratch features of a board in board_rows encoding
+    static BoardFeatures computeFeatures(const uint16_t* rows);
+
+    // Snapshot of the full game state. Throws std::invalid_argument if
+    // queue_size > GameState::MaxQueue or for COMPAT games.
+    GameState snapshot() const;
+    // Resumes from a snapshot; false (and no change) if it was taken with a
+    // different queue size
+    bool restore(const GameState& state);
+
+    // Lists every distinct resting position the current piece can reach
+    // under the step() rules (each move followed by a gravity tick, no wall
+    // kicks), plus the held (or next, if the holder is empty) piece's when
+    // include_hold. with_boards also keeps each resulting visible board,
+    // read back through getPlacementBoard. Valid until the state changes.
+    const std::vector<Placement>& enumeratePlacements(bool include_hold = false, bool with_boards = false);
+    const std::vector<Placement>& getPlacements() const { return placements; }
+    // BOARD_HEIGHT rows, bit x = column x; only after enumerating with boards
+    const uint16_t* getPlacementBoard(size_t index) const;
+    // Moves the piece straight to getPlacements()[index] and locks it with
+    // one step(); an out-of-range index is a NOOP step
+    StepResult stepPlacement(size_t index);
+    // Same for a placement enumerated from this exact state earlier, e.g.
+    // before a snapshot was restored (restore drops getPlacements())
+    StepResult stepPlacement(Placement placement);
+
+    // Materializes the observation on demand, rewriting only the parts
+    // that changed since the last call. updateObservation() forces a
+    // full re-render (needed after editing current_* fields directly).
+    const Observation& getObservation();
 
     // Made public for testing - consider friend class for production
     void spawnPiece();
@@ -60,14 +250,73 @@ public:
     int8_t queue_size;
     std::vector<int> clearing_lines;  // Lines currently being cleared (for animation)
     TimeManager tm;
-    Observation obs;
     std::vector<uint8_t> queue;
     uint8_t queue_index; // circular buffer
     uint8_t holder_type;
+    PieceSource pieces;
+    // Draws COMPAT pieces. At 5 KB it stays out of GameState, so COMPAT
+    // games cannot be snapshotted.
+    std::mt19937 compat_rng;
 
     // current piece data
     int8_t current_x;
     int8_t current_y;
     uint8_t current_piece_type;
     uint8_t rotation; // 0-3 possible options
+
+    // Board is stored as one bitmask per row: bit (x + BoardWall) is column x.
+    // Bits outside the playable width are always set so the walls collide
+    // like locked cells, and a full row compares equal to FullRow.
+    using Rules = BoardRules<Tetris::BOARD_WIDTH, Observation::BoardH, Tetris::BOARD_HEIGHT>;
+    static constexpr int BoardWall = Rules::Wall;
+    static constexpr uint16_t FullRow = Rules::FullRow;
+    static constexpr uint16_t EmptyRow = Rules::EmptyRow;
+
+private:
+    friend struct StepRules;
+    static int spawnX(uint8_t type) { return Tetris::PIECE_TABLE.spawn_x[type]; }
+    static int spawnY(uint8_t type) { return Tetris::PIECE_TABLE.spawn_y[type]; }
+    void clearBoard();
+    void markBoardRows(int lo, int hi);
+    void markFeatureColumns(int lo, int hi);
+    void refreshFeatures();
+    // Height of column x counting only rows below `top`
+    uint8_t columnHeightBelow(int x, int top) const;
+    bool collidesAt(uint8_t type, int x, int y, uint8_t rot) const;
+    int landingY(uint8_t type, int x, int y, uint8_t rot) const;
+    void searchPlacements(uint8_t type, int x, int y, uint8_t rot, bool use_hold, bool with_boards);
+    void addPlacement(uint8_t type, int x, int y, uint8_t rot, bool use_hold, bool with_boards);
+    void refreshObservation();
+
+    uint16_t board_rows[Observation::BoardH];
+    uint8_t board_cells[Observation::BoardH][Tetris::BOARD_WIDTH]; // piece_type + 1, 0 = empty
+    uint8_t column_heights[Tetris::BOARD_WIDTH];
+    Observation obs;
+
+    // Observation upkeep. Board rows and the queue are flagged by the code
+    // that changes them; the active piece and holder are compared against
+    // what was last rendered, since tests and tools poke those fields.
+    struct RenderedPiece {
+        int8_t x;
+        int8_t y;
+        uint8_t type;
+        uint8_t rotation;
+    };
+    int8_t board_dirty_lo; // inclusive dirty row range, empty when lo > hi
+    int8_t board_dirty_hi;
+    bool queue_dirty;
+    bool active_rendered;
+    RenderedPiece rendered_piece;
+    uint8_t rendered_holder;
+
+    // Feature upkeep: columns flagged by bit, rows by inclusive range
+    BoardFeatures features;
+    uint8_t row_transitions[Tetris::BOARD_HEIGHT];
+    uint16_t feature_cols_dirty;
+    int8_t feature_rows_lo;
+    int8_t feature_rows_hi;
+
+    std::vector<Placement> placements;
+    std::vector<uint64_t> placement_keys;   // locked-cell footprints, for dedup
+    std::vector<uint16_t> placement_boards; // BOARD_HEIGHT rows per placement
 };
@@ -0,0 +1,82 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "pieceSource.h"
+#include "tetrisGame.h"
+#include "vecTetris.h"
+#include "workerPool.h"
+
+// N games stepped by one call, for the Python vector env. The envs are split
+// into one VecTetris shard per pool worker, and each step writes
+// observations, rewards and done flags into buffers allocated once here.
+// Finished episodes reset on the spot (gymnasium's same-step autoreset):
+// their observation row is the next episode's first, and the last one is
+// kept in finalObservations(). Env i plays like
+// TetrisGame(SIMULATION, queue_size, seed_base + i, randomizer).
+class TetrisVecEnv {
+public:
+    TetrisVecEnv(size_t num_envs, uint8_t queue_size = 3, uint32_t seed_base = 0,
+                 PieceRandomizer randomizer = PieceRandomizer::UNIFORM, size_t num_threads = 1,
+                 uint32_t max_episode_steps = 0, ObsDtype obs_dtype = ObsDtype::FLOAT32);
+
+    // Resets every env. seeds (num_envs values) restart each env's piece
+    // sequence; null continues the current sequences.
+    void reset(const uint32_t* seeds = nullptr);
+    // actions[i] for env i, then one gravity tick each (TetrisGame::step)
+    void step(const int32_t* actions);
+
+    size_t size() const { return num_envs_; }
+    uint8_t queueSize() const { return queue_size_; }
+    ObsDtype obsDtype() const { return obs_dtype_; }
+    // Cells per observation
+    size_t obsDim() const { return obs_dim_; }
+    // Elements per observation row: obsDim(), or the packed bytes for PACKED
+    size_t storedObsDim() const { return stored_obs_dim_; }
+    size_t numThreads() const { return pool_.size(); }
+    uint32_t maxEpisodeSteps() const { return max_episode_steps_; }
+
+    // [num_envs, storedObsDim()] rows; float for FLOAT32, bytes otherwise
+    const float* observations() const { return obs_float_.data(); }
+    const uint8_t* observationBytes() const { return obs_bytes_.data(); }
+    // Last observation of the episodes that ended on the latest step (same layout)
+    const float* finalObservations() const { return final_float_.data(); }
+    const uint8_t* finalObservationBytes() const { return final_bytes_.data(); }
+    const float* rewards() const { return rewards_.data(); }
+    const uint8_t* terminated() const { return terminated_.data(); }
+    // max_episode_steps reached without topping out
+    const uint8_t* truncated() const { return truncated_.data(); }
+    // Score and length of the episodes that ended on the latest step
+    const int32_t* finalScores() const { return final_scores_.data(); }
+    const uint32_t* finalLengths() const { return final_lengths_.data(); }
+
+private:
+    struct Shard {
+        size_t begin;  // first env
+        std::unique_ptr<VecTetris> vec;
+        std::vector<uint8_t> cells;  // one rendered observation
+    };
+
+    void writeObservation(Shard& shard, size_t local, bool final_row);
+
+    size_t num_envs_;
+    uint8_t queue_size_;
+    uint32_t max_episode_steps_;
+    ObsDtype obs_dtype_;
+    size_t obs_dim_;
+    size_t stored_obs_dim_;
+
+    std::vector<float> obs_float_;
+    std::vector<uint8_t> obs_bytes_;
+    std::vector<float> final_float_;
+    std::vector<uint8_t> final_bytes_;
+    std::vector<float> rewards_;
+    std::vector<uint8_t> terminated_;
+    std::vector<uint8_t> truncated_;
+    std::vector<int32_t> final_scores_;
+    std::vector<uint32_t> final_lengths_;
+    std::vector<uint32_t> lengths_;
+
+    std::vector<Shard> shards_;
+    WorkerPool pool_;
+};
@@ -9,6 +9,7 @@ public:
     TimeManager(Mode m);
     double getDeltaTime();
     bool needRendering();
+    Mode getMode() const { return mode; }
 
 private:
     Mode mode;
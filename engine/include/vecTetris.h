@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <random>
+#include "pieceSource.h"
+#include <vector>
+#include "constants.h"
+#include "tetrisGame.h"
+
+// N independent games advanced together. State is kept struct-of-arrays so
+// the per-step collision tests run across envs (AVX2 when compiled with it,
+// scalar otherwise). Env i follows exactly the same rules and piece
+// sequence as TetrisGame(SIMULATION, queue_size, seed_base + i, randomizer).
+class VecTetris {
+public:
+    VecTetris(size_t num_envs, uint8_t queue_size = 3, uint32_t seed_base = 0,
+              PieceRandomizer randomizer = PieceRandomizer::UNIFORM);
+
+    void reset(size_t env);
+    void resetAll();
+    // Applies actions[i] to env i followed by one gravity tick, like
+    // TetrisGame::step. Results are read back through rewards()/terminated().
+    void step(const int* actions);
+
+    size_t size() const { return num_envs_; }
+    const float* rewards() const { return rewards_.data(); }
+    const uint8_t* terminated() const { return game_over.data(); }
+
+    uint8_t getCell(size_t env, int x, int y) const;
+    int getGhostY(size_t env) const;
+    // Writes env's observation in the same flat layout as Observation::data()
+    void renderObservation(size_t env, uint8_t* dest) const;
+    size_t obsSize() const { return obs_size_; }
+
+    // Per-env state, indexed by env (board/queue arrays by env * stride)
+    uint8_t queue_size;
+    std::vector<uint16_t> board_rows;   // [env * BoardH + y], TetrisGame row encoding
+    std::vector<uint8_t> board_cells;   // [(env * BoardH + y) * BOARD_WIDTH + x]
+    std::vector<uint8_t> column_heights; // [env * BOARD_WIDTH + x], as TetrisGame::getColumnHeights
+    std::vector<int8_t> current_x;
+    std::vector<int8_t> current_y;
+    std::vector<uint8_t> current_piece_type;
+    std::vector<uint8_t> rotation;
+    std::vector<uint8_t> holder_type;
+    std::vector<uint8_t> queue;         // [env * queue_size + i]
+    std::vector<uint8_t> queue_index;
+    std::vector<int32_t> score;
+    std::vector<uint8_t> game_over;
+    std::vector<PieceSource> piece_sources;
+
+private:
+    using Rules = TetrisGame::Rules;
+
+    // One env's fields under the names StepRules expects. Locks queue their
+    // full rows in the view, so call completeClearLines() before dropping it.
+    struct EnvView {
+        using Rules = VecTetris::Rules;
+        static int spawnX(uint8_t type) { return Tetris::PIECE_TABLE.spawn_x[type]; }
+        static int spawnY(uint8_t type) { return Tetris::PIECE_TABLE.spawn_y[type]; }
+
+        uint8_t getNextPiece() { return vec.getNextPiece(env); }
+        int getGhostY() const { return vec.getGhostY(env); }
+        void lockPiece();
+        int clearLines();
+        void completeClearLines();
+
+        VecTetris& vec;
+        size_t env;
+        uint16_t* board_rows;
+        int8_t& current_x;
+        int8_t& current_y;
+        uint8_t& rotation;
+        uint8_t& current_piece_type;
+        uint8_t& holder_type;
+        int32_t& score;
+        float& scored;
+        uint8_t& game_over;
+        int clearing_y;
+        unsigned clearing_rows;
+    };
+    EnvView view(size_t env);
+
+    uint8_t samplePiece(size_t env);
+    uint8_t getNextPiece(size_t env);
+    // hits[i] = collision of env i's current piece at (xs[i], ys[i], rots[i])
+    void collideBatch(const int8_t* xs, const int8_t* ys, const uint8_t* rots, uint8_t* hits) const;
+
+    size_t num_envs_;
+    size_t obs_size_;
+    std::vector<float> rewards_;
+
+    // Scratch for the batched collision passes
+    std::vector<int8_t> cand_x_;
+    std::vector<int8_t> cand_y_;
+    std::vector<uint8_t> cand_rot_;
+    std::vector<uint8_t> moving_;
+    std::vector<uint8_t> hits_;
+};
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Persistent threads for fork-join loops. The calling thread takes part as
+// worker 0, so a pool of one spawns no threads at all.
+class WorkerPool {
+public:
+    using Task = std::function<void(size_t worker, size_t begin, size_t end)>;
+
+    // num_threads = 0 uses the hardware concurrency. With cpus, worker w > 0
+    // is pinned to cpus[w % cpus.size()]; the calling thread is left alone.
+    explicit WorkerPool(size_t num_threads, std::vector<int> cpus = {});
+    ~WorkerPool();
+    WorkerPool(const WorkerPool&) = delete;
+    WorkerPool& operator=(const WorkerPool&) = delete;
+
+    size_t size() const { return errors_.size(); }
+
+    // Runs fn(worker, begin, end) over [0, count) split evenly across the
+    // workers (every worker is called, possibly with an empty range) and
+    // returns once all are done. Rethrows the first worker's exception.
+    void parallelFor(size_t count, const Task& fn);
+
+private:
+    void loop(size_t worker);
+
+    std::vector<int> cpus_;
+    std::vector<std::exception_ptr> errors_;
+    std::vector<std::thread> threads_;
+    std::mutex mutex_;
+    std::condition_variable start_cv_;
+    std::condition_variable done_cv_;
+    const Task* task_ = nullptr;
+    size_t task_count_ = 0;
+    uint64_t generation_ = 0;
+    size_t pending_ = 0;
+    bool stopping_ = false;
+};
@@ -46,7 +46,7 @@ int main() {
             if (!game.clearing_lines.empty()) {
                 // Show flashing animation for 400ms
                 for (int i = 0; i < 4; i++) {
-                    SDLRenderer::render(game.obs, game.score, game.game_over, game.clearing_lines);
+                    SDLRenderer::render(game.getObservation(), game.score, game.game_over, game.clearing_lines);
                     SDL_Delay(100);
                 }
                 // Actually clear the lines now
@@ -58,12 +58,12 @@ int main() {
         }
         
         // Render at full frame rate
-        SDLRenderer::render(game.obs, game.score, game.game_over, game.clearing_lines);
+        SDLRenderer::render(game.getObservation(), game.score, game.game_over, game.clearing_lines);
     }
     
     // Game over screen
     if (game.isGameOver() && !quit) {
-        SDLRenderer::render(game.obs, game.score, true);
+        SDLRenderer::render(game.getObservation(), game.score, true);
         
         // Wait for quit
         while (!quit) {
@@ -0,0 +1,206 @@
+#include "mlpPolicy.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+#if defined(__AVX2__) && defined(__FMA__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+// Rows of the input processed together, so each weight row is loaded once
+// per block instead of once per row
+constexpr size_t RowBlock = 4;
+
+#if defined(__AVX2__) && defined(__FMA__)
+float horizontalSum(__m256 v) {
+    const __m128 sum4 = _mm_add_ps(_mm256_castps256_ps128(v), _mm256_extractf128_ps(v, 1));
+    const __m128 sum2 = _mm_add_ps(sum4, _mm_movehl_ps(sum4, sum4));
+    return _mm_cvtss_f32(_mm_add_ss(sum2, _mm_shuffle_ps(sum2, sum2, 1)));
+}
+#endif
+
+// dots[r] = w . in[r] for RowBlock rows of length n, rows `stride` apart
+void dotBlock(const float* w, const float* in, size_t stride, size_t n, float* dots) {
+    size_t k = 0;
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 acc[RowBlock];
+    for (size_t r = 0; r < RowBlock; r++) {
+        acc[r] = _mm256_setzero_ps();
+    }
+    for (; k + 8 <= n; k += 8) {
+        const __m256 wk = _mm256_loadu_ps(w + k);
+        for (size_t r = 0; r < RowBlock; r++) {
+            acc[r] = _mm256_fmadd_ps(wk, _mm256_loadu_ps(in + r * stride + k), acc[r]);
+        }
+    }
+    for (size_t r = 0; r < RowBlock; r++) {
+        dots[r] = horizontalSum(acc[r]);
+    }
+#else
+    // Eight independent partial sums per row: the compiler can keep them in
+    // one vector register without reassociating a single running sum
+    float acc[RowBlock][8] = {};
+    for (; k + 8 <= n; k += 8) {
+        for (size_t r = 0; r < RowBlock; r++) {
+            for (size_t l = 0; l < 8; l++) {
+                acc[r][l] += w[k + l] * in[r * stride + k + l];
+            }
+        }
+    }
+    for (size_t r = 0; r < RowBlock; r++) {
+        float sum = 0.0f;
+        for (size_t l = 0; l < 8; l++) {
+            sum += acc[r][l];
+        }
+        dots[r] = sum;
+    }
+#endif
+    for (; k < n; k++) {
+        for (size_t r = 0; r < RowBlock; r++) {
+            dots[r] += w[k] * in[r * stride + k];
+        }
+    }
+}
+
+float dot(const float* w, const float* in, size_t n) {
+    size_t k = 0;
+    float sum = 0.0f;
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 acc = _mm256_setzero_ps();
+    for (; k + 8 <= n; k += 8) {
+        acc = _mm256_fmadd_ps(_mm256_loadu_ps(w + k), _mm256_loadu_ps(in + k), acc);
+    }
+    sum = horizontalSum(acc);
+#else
+    float acc[8] = {};
+    for (; k + 8 <= n; k += 8) {
+        for (size_t l = 0; l < 8; l++) {
+            acc[l] += w[k + l] * in[k + l];
+        }
+    }
+    for (size_t l = 0; l < 8; l++) {
+        sum += acc[l];
+    }
+#endif
+    for (; k < n; k++) {
+        sum += w[k] * in[k];
+    }
+    return sum;
+}
+
+void checkLayer(const MlpPolicy::Layer& layer, const char* name) {
+    if (layer.inputs == 0 || layer.outputs == 0) {
+        throw std::invalid_argument(std::string(name) + " layer is empty");
+    }
+    if (layer.weights.size() != layer.inputs * layer.outputs || layer.bias.size() != layer.outputs) {
+        throw std::invalid_argument(std::string(name) + " weights must be [outputs, inputs] with [outputs] bias");
+    }
+}
+
+}  // namespace
+
+MlpPolicy::MlpPolicy(std::vector<Layer> hidden, Layer actor, Layer critic)
+    : hidden_(std::move(hidden)), actor_(std::move(actor)), critic_(std::move(critic)) {
+    size_t width = 0;
+    for (const Layer& layer : hidden_) {
+        checkLayer(layer, "hidden");
+        if (width && layer.inputs != width) {
+            throw std::invalid_argument("hidden layer inputs must match the previous layer's outputs");
+        }
+        width = layer.outputs;
+        max_width_ = std::max(max_width_, width);
+    }
+    checkLayer(actor_, "actor");
+    checkLayer(critic_, "critic");
+    if (width && (actor_.inputs != width || critic_.inputs != width)) {
+        throw std::invalid_argument("actor and critic inputs must match the last hidden layer's outputs");
+    }
+    if (!width && actor_.inputs != critic_.inputs) {
+        throw std::invalid_argument("actor and critic must take the same inputs");
+    }
+    if (critic_.outputs != 1) {
+        throw std::invalid_argument("critic must have a single output");
+    }
+}
+
+void MlpPolicy::dense(const Layer& layer, const float* in, size_t rows, float* out, bool apply_tanh) {
+    const size_t n = layer.inputs;
+    const size_t m = layer.outputs;
+    size_t r = 0;
+    float dots[RowBlock];
+    for (; r + RowBlock <= rows; r += RowBlock) {
+        for (size_t o = 0; o < m; o++) {
+            dotBlock(layer.weights.data() + o * n, in + r * n, n, n, dots);
+            for (size_t b = 0; b < RowBlock; b++) {
+                out[(r + b) * m + o] = dots[b] + layer.bias[o];
+            }
+        }
+    }
+    for (; r < rows; r++) {
+        for (size_t o = 0; o < m; o++) {
+            out[r * m + o] = dot(layer.weights.data() + o * n, in + r * n, n) + layer.bias[o];
+        }
+    }
+    if (apply_tanh) {
+        for (size_t i = 0; i < rows * m; i++) {
+            out[i] = std::tanh(out[i]);
+        }
+    }
+}
+
+void MlpPolicy::forward(const float* obs, size_t rows, float* logits, float* values, Scratch& scratch) const {
+    if (scratch.a.size() < rows * max_width_) {
+        scratch.a.resize(rows * max_width_);
+        scratch.b.resize(rows * max_width_);
+    }
+    const float* features = obs;
+    float* next = scratch.a.data();
+    for (const Layer& layer : hidden_) {
+        dense(layer, features, rows, next, true);
+        features = next;
+        next = next == scratch.a.data() ? scratch.b.data() : scratch.a.data();
+    }
+    dense(actor_, features, rows, logits, false);
+    dense(critic_, features, rows, values, false);
+}
+
+void MlpPolicy::act(const float* obs, size_t rows, PieceRng* const* rngs, Sample* out, Scratch& scratch) const {
+    const size_t actions = numActions();
+    if (scratch.logits.size() < rows * actions) {
+        scratch.logits.resize(rows * actions);
+    }
+    if (scratch.values.size() < rows) {
+        scratch.values.resize(rows);
+    }
+    forward(obs, rows, scratch.logits.data(), scratch.values.data(), scratch);
+    for (size_t r = 0; r < rows; r++) {
+        out[r] = sample(scratch.logits.data() + r * actions, scratch.values[r], *rngs[r]);
+    }
+}
+
+MlpPolicy::Sample MlpPolicy::sample(const float* logits, float value, PieceRng& rng) const {
+    // Categorical(logits=...) as in torch: log_prob = logit - logsumexp
+    const size_t actions = numActions();
+    const float max_logit = *std::max_element(logits, logits + actions);
+    float total = 0.0f;
+    for (size_t a = 0; a < actions; a++) {
+        total += std::exp(logits[a] - max_logit);
+    }
+    // 24 random bits: a uniform float in [0, total)
+    const float u = static_cast<float>(rng() >> 8) * (1.0f / 16777216.0f) * total;
+    size_t action = actions - 1;
+    float cumulative = 0.0f;
+    for (size_t a = 0; a < actions; a++) {
+        cumulative += std::exp(logits[a] - max_logit);
+        if (u < cumulative) {
+            action = a;
+            break;
+        }
+    }
+    const float log_prob = logits[action] - max_logit - std::log(total);
+    return Sample{static_cast<int>(action), log_prob, value};
+}
@@ -0,0 +1,162 @@
+#include "tetrisGame.h"
+#include "pieceTables.h"
+#include <cstring>
+
+// Placement (afterstate) enumeration for TetrisGame. Kept apart from the
+// core step() code since only macro-action agents and planners use it.
+
+namespace {
+
+// Piece origins can sit up to 3 cells left of / below the board when the
+// piece's 4x4 box has empty leading columns / rows
+constexpr int OriginOffset = Tetris::PIECE_SIZE - 1;
+constexpr int XSpan = Tetris::BOARD_WIDTH + OriginOffset;
+constexpr int YSpan = Observation::BoardH + OriginOffset;
+constexpr int MaxNodes = Tetris::NUM_ROTATIONS * YSpan * XSpan;
+
+struct SearchNode {
+    int8_t x;
+    int8_t y;
+    uint8_t rot;
+};
+
+}  // namespace
+
+const std::vector<Placement>& TetrisGame::enumeratePlacements(bool include_hold, bool with_boards) {
+    placements.clear();
+    placement_keys.clear();
+    placement_boards.clear();
+
+    if (!collidesAt(current_piece_type, current_x, current_y, rotation)) {
+        // The current piece has already had this step's gravity tick
+        searchPlacements(current_piece_type, current_x, current_y, rotation, false, with_boards);
+    }
+    if (include_hold) {
+        // SWAP brings in the held piece, or the next one while the holder is empty
+        const uint8_t type = holder_type == 7 ? queue[queue_index] : holder_type;
+        const int x = Tetris::PIECE_TABLE.spawn_x[type];
+        const int y = Tetris::PIECE_TABLE.spawn_y[type];
+        if (!collidesAt(type, x, y, 0)) {
+            // The SWAP step ends with a gravity tick of its own
+            if (collidesAt(type, x, y - 1, 0)) {
+                addPlacement(type, x, y, 0, true, with_boards);
+            } else {
+                searchPlacements(type, x, y - 1, 0, true, with_boards);
+            }
+        }
+    }
+    return placements;
+}
+
+void TetrisGame::searchPlacements(uint8_t type, int x, int y, uint8_t rot, bool use_hold, bool with_boards) {
+    bool visited[Tetris::NUM_ROTATIONS][YSpan][XSpan] = {};
+    SearchNode nodes[MaxNodes];
+    int head = 0;
+    int tail = 0;
+
+    auto visit = [&](int nx, int ny, uint8_t nrot) {
+        bool& seen = visited[nrot][ny + OriginOffset][nx + OriginOffset];
+        if (!seen) {
+            seen = true;
+            nodes[tail++] = SearchNode{static_cast<int8_t>(nx), static_cast<int8_t>(ny), nrot};
+        }
+    };
+    // One step: the move (reverted on collision, as in applyAction), then gravity
+    auto settle = [&](int nx, int ny, uint8_t nrot, const SearchNode& from) {
+        if (collidesAt(type, nx, ny, nrot)) {
+            nx = from.x;
+            ny = from.y;
+            nrot = from.rot;
+        }
+        if (collidesAt(type, nx, ny - 1, nrot)) {
+            addPlacement(type, nx, ny, nrot, use_hold, with_boards);
+        } else {
+            visit(nx, ny - 1, nrot);
+        }
+    };
+
+    visit(x, y, rot);
+    while (head < tail) {
+        const SearchNode node = nodes[head++];
+        settle(node.x - 1, node.y, node.rot, node);                          // LEFT
+        settle(node.x + 1, node.y, node.rot, node);                          // RIGHT
+        settle(node.x, node.y - 1, node.rot, node);                          // DOWN
+        settle(node.x, node.y, (node.rot + 1) % Tetris::NUM_ROTATIONS, node); // CW
+        settle(node.x, node.y, (node.rot + 3) % Tetris::NUM_ROTATIONS, node); // CCW
+        settle(node.x, node.y, node.rot, node);                              // NOOP
+        addPlacement(type, node.x, landingY(type, node.x, node.y, node.rot), node.rot, use_hold, with_boards); // DROP
+    }
+}
+
+void TetrisGame::addPlacement(uint8_t type, int x, int y, uint8_t rot, bool use_hold, bool with_boards) {
+    const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[type][rot];
+
+    // Rotations that lock the same cells (O, and I/S/Z shifted) are one placement
+    uint64_t key = use_hold;
+    for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+        key = (key << 10) | (static_cast<uint64_t>(y + shape.cell_y[i]) << 5) |
+              static_cast<uint64_t>(x + shape.cell_x[i]);
+    }
+    for (uint64_t seen : placement_keys) {
+        if (seen == key) {
+            return;
+        }
+    }
+    placement_keys.push_back(key);
+
+    // Lock into a copy of the board and clear, as lockPiece/completeClearLines would
+    uint16_t rows[Observation::BoardH];
+    std::memcpy(rows, board_rows, sizeof(rows));
+    for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+        rows[y + shape.cell_y[i]] |= static_cast<uint16_t>(1u << (x + shape.cell_x[i] + BoardWall));
+    }
+    int cleared = 0;
+    for (int r = Tetris::PIECE_SIZE - 1; r >= 0; r--) {
+        const int row = y + r;
+        if (row < 0 || row >= Tetris::BOARD_HEIGHT || rows[row] != FullRow) {
+            continue;
+        }
+        std::memmove(rows + row, rows + row + 1, (Tetris::BOARD_HEIGHT - 1 - row) * sizeof(rows[0]));
+        rows[Tetris::BOARD_HEIGHT - 1] = EmptyRow;
+        cleared++;
+    }
+
+    placements.push_back(Placement{static_cast<int8_t>(x), static_cast<int8_t>(y), rot, type, use_hold,
+                                   static_cast<uint8_t>(cleared), computeFeatures(rows)});
+    if (with_boards) {
+        static constexpr uint16_t PlayableMask = (1u << Tetris::BOARD_WIDTH) - 1;
+        for (int row = 0; row < Tetris::BOARD_HEIGHT; row++) {
+            placement_boards.push_back(static_cast<uint16_t>((rows[row] >> BoardWall) & PlayableMask));
+        }
+    }
+}
+
+const uint16_t* TetrisGame::getPlacementBoard(size_t index) const {
+    const size_t offset = index * Tetris::BOARD_HEIGHT;
+    if (offset + Tetris::BOARD_HEIGHT > placement_boards.size()) {
+        return nullptr;
+    }
+    return placement_boards.data() + offset;
+}
+
+StepResult TetrisGame::stepPlacement(size_t index) {
+    if (index >= placements.size()) {
+        return step(Action::NOOP);
+    }
+    return stepPlacement(placements[index]);
+}
+
+StepResult TetrisGame::stepPlacement(Placement placement) {
+    placements.clear();
+    placement_keys.clear();
+    placement_boards.clear();
+
+    if (placement.use_hold) {
+        applyAction(Action::SWAP);
+    }
+    // The placement is resting, so the gravity tick of this step locks it
+    current_x = placement.x;
+    current_y = placement.y;
+    rotation = placement.rotation;
+    return step(Action::NOOP);
+}
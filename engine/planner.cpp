@@ -0,0 +1,340 @@
+#include "planner.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+uint64_t splitmix64(uint64_t x) {
+    x += 0x9e3779b97f4a7c15ULL;
+    x = (x ^ (x >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    x = (x ^ (x >> 27)) * 0x94d049bb133111ebULL;
+    return x ^ (x >> 31);
+}
+
+// Column offsets inside a TetrisGame::writeAfterstate row
+constexpr int LinesColumn = 0;
+constexpr int BoardColumn = 1;
+constexpr int TotalHolesColumn = BoardColumn + 2 * Tetris::BOARD_WIDTH + 2;
+constexpr int RowTransitionsColumn = TotalHolesColumn + 2;
+constexpr int ColumnTransitionsColumn = RowTransitionsColumn + 1;
+constexpr int CumulativeWellsColumn = ColumnTransitionsColumn + 1;
+static_assert(CumulativeWellsColumn + 1 == TetrisGame::AfterstateSize, "afterstate layout changed");
+
+}  // namespace
+
+LinearValue LinearValue::elTetris() {
+    LinearValue value;
+    value.weights[LinesColumn] = 3.4181268f;
+    value.weights[RowTransitionsColumn] = -3.2178882f;
+    value.weights[ColumnTransitionsColumn] = -9.3486953f;
+    value.weights[TotalHolesColumn] = -7.8992654f;
+    value.weights[CumulativeWellsColumn] = -3.3855972f;
+    return value;
+}
+
+float LinearValue::operator()(const float* afterstate) const {
+    float sum = 0.0f;
+    for (int i = 0; i < TetrisGame::AfterstateSize; i++) {
+        sum += weights[i] * afterstate[i];
+    }
+    return sum;
+}
+
+TetrisPlanner::TetrisPlanner(const PlannerConfig& config, uint8_t queue_size)
+    : config_(config), queue_size_(queue_size), linear_(LinearValue::elTetris()), pool_(config.num_threads) {
+    if (queue_size_ > GameState::MaxQueue) {
+        throw std::invalid_argument("the planner supports queue_size up to " + std::to_string(GameState::MaxQueue));
+    }
+    config_.num_threads = pool_.size();
+    config_.depth = std::max(config_.depth, 1);
+    config_.beam_width = std::max(config_.beam_width, 1);
+    config_.simulations = std::max(config_.simulations, 1);
+
+    workers_.resize(config_.num_threads);
+    for (WorkerScratch& worker : workers_) {
+        worker.game = std::make_unique<TetrisGame>(TimeManager::SIMULATION, queue_size_, 0);
+    }
+}
+
+void TetrisPlanner::setValueFn(ValueFn fn) {
+    value_fn_ = std::move(fn);
+}
+
+void TetrisPlanner::evaluate(const float* rows, size_t count, float* values) const {
+    if (count == 0) {
+        return;
+    }
+    if (value_fn_) {
+        value_fn_(rows, count, values);
+        return;
+    }
+    for (size_t i = 0; i < count; i++) {
+        values[i] = linear_(rows + i * TetrisGame::AfterstateSize);
+    }
+}
+
+PlanResult TetrisPlanner::plan(const GameState& root) {
+    if (root.queue_size != queue_size_) {
+        throw std::invalid_argument("game queue_size does not match the planner's");
+    }
+    if (root.game_over) {
+        return PlanResult{};
+    }
+    for (WorkerScratch& worker : workers_) {
+        worker.pieces = 0;
+    }
+    PlanResult result = config_.algorithm == PlannerConfig::MCTS ? planMcts(root) : planBeam(root);
+    for (const WorkerScratch& worker : workers_) {
+        result.pieces_simulated += worker.pieces;
+    }
+    plan_count_++;
+    return result;
+}
+
+size_t TetrisPlanner::expandChildren(WorkerScratch& worker, const GameState& state) {
+    TetrisGame& game = *worker.game;
+    game.restore(state);
+    worker.placements = game.enumeratePlacements(config_.use_hold);
+    worker.children.clear();
+
+    for (const Placement& placement : worker.placements) {
+        game.restore(state);
+        const StepResult step = game.stepPlacement(placement);
+        worker.children.push_back(Child{game.snapshot(), step.reward, step.terminated});
+
+        const size_t offset = worker.rows.size();
+        worker.rows.resize(offset + TetrisGame::AfterstateSize);
+        TetrisGame::writeAfterstate(placement, worker.rows.data() + offset);
+    }
+    worker.pieces += worker.placements.size();
+    return worker.placements.size();
+}
+
+// Beam search: expand every kept node in parallel, score all children in
+// one batch (one value_fn call per level), keep the best beam_width.
+PlanResult TetrisPlanner::planBeam(const GameState& root) {
+    PlanResult result;
+
+    beam_.clear();
+    beam_.push_back(Candidate{root, 0.0f, 0.0f, -1, -1, false});
+    beam_.front().state.pieces.reseed(splitmix64(config_.seed ^ splitmix64(plan_count_)));
+
+    float discount = 1.0f;  // gamma^level
+    size_t root_actions = 0;
+    for (int level = 0; level < config_.depth; level++) {
+        pool_.parallelFor(beam_.size(), [&](size_t w, size_t begin, size_t end) {
+            WorkerScratch& worker = workers_[w];
+            worker.candidates.clear();
+            worker.rows.clear();
+            for (size_t i = begin; i < end; i++) {
+                const Candidate& node = beam_[i];
+                if (node.terminal) {
+                    worker.candidates.push_back(node);
+                    worker.candidates.back().row = -1;
+                    continue;
+                }
+                const size_t count = expandChildren(worker, node.state);
+                for (size_t c = 0; c < count; c++) {
+                    const Child& child = worker.children[c];
+                    const int32_t row = static_cast<int32_t>(worker.rows.size() / TetrisGame::AfterstateSize - count + c);
+                    worker.candidates.push_back(Candidate{
+                        child.state, node.ret + discount * child.reward, 0.0f,
+                        level == 0 ? static_cast<int32_t>(c) : node.root_action, row, child.terminal});
+                }
+            }
+        });
+
+        // Gather in worker order, so the result does not depend on timing
+        next_.clear();
+        rows_.clear();
+        for (WorkerScratch& worker : workers_) {
+            const int32_t row_base = static_cast<int32_t>(rows_.size() / TetrisGame::AfterstateSize);
+            for (Candidate& candidate : worker.candidates) {
+                if (candidate.row >= 0) {
+                    candidate.row += row_base;
+                }
+                next_.push_back(candidate);
+            }
+            rows_.insert(rows_.end(), worker.rows.begin(), worker.rows.end());
+        }
+        if (level == 0) {
+            root_actions = next_.size();
+        }
+        if (next_.empty()) {
+            break;
+        }
+
+        values_.resize(rows_.size() / TetrisGame::AfterstateSize);
+        evaluate(rows_.data(), values_.size(), values_.data());
+        discount *= config_.discount;
+        bool all_terminal = true;
+        for (Candidate& candidate : next_) {
+            if (candidate.row >= 0) {
+                candidate.score = candidate.ret +
+                    discount * (candidate.terminal ? config_.terminal_value : values_[candidate.row]);
+            }
+            all_terminal = all_terminal && candidate.terminal;
+        }
+
+        const size_t keep = std::min(next_.size(), static_cast<size_t>(config_.beam_width));
+        std::partial_sort(next_.begin(), next_.begin() + keep, next_.end(),
+                          [](const Candidate& a, const Candidate& b) { return a.score > b.score; });
+        next_.resize(keep);
+        beam_.swap(next_);
+        if (all_terminal) {
+            break;
+        }
+    }
+
+    result.root_scores.assign(root_actions, -std::numeric_limits<float>::infinity());
+    for (const Candidate& candidate : beam_) {
+        if (candidate.root_action < 0) {
+            continue;
+        }
+        float& best = result.root_scores[candidate.root_action];
+        best = std::max(best, candidate.score);
+    }
+    if (root_actions > 0) {
+        // beam_ is sorted best first
+        result.placement = beam_.front().root_action;
+        result.value = beam_.front().score;
+    }
+    return result;
+}
+
+// Root-parallel MCTS: each worker grows its own tree over a differently
+// reseeded copy of the root, and the root visit counts are summed.
+PlanResult TetrisPlanner::planMcts(const GameState& root) {
+    PlanResult result;
+    const size_t num_workers = workers_.size();
+    const int simulations = static_cast<int>((config_.simulations + num_workers - 1) / num_workers);
+
+    pool_.parallelFor(num_workers, [&](size_t, size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++) {
+            GameState reseeded = root;
+            reseeded.pieces.reseed(splitmix64(config_.seed ^ splitmix64(plan_count_ * num_workers + i)));
+            runMcts(workers_[i], reseeded, simulations);
+        }
+    });
+
+    // The root placement list only depends on the board, so child c is the
+    // same placement in every tree
+    const size_t root_actions = workers_[0].tree.empty() ? 0 : workers_[0].tree[0].num_children;
+    std::vector<double> value_sums(root_actions, 0.0);
+    result.root_scores.assign(root_actions, 0.0f);
+    for (const WorkerScratch& worker : workers_) {
+        const MctsNode& node = worker.tree[0];
+        for (size_t c = 0; c < root_actions && c < node.num_children; c++) {
+            const MctsNode& child = worker.tree[node.first_child + c];
+            const float q = child.reward + config_.discount *
+                (child.visits ? child.value_sum / child.visits : child.value);
+            result.root_scores[c] += static_cast<float>(child.visits);
+            value_sums[c] += static_cast<double>(q) * std::max(child.visits, 1u);
+        }
+    }
+    if (root_actions > 0) {
+        const size_t best = static_cast<size_t>(
+            std::max_element(result.root_scores.begin(), result.root_scores.end()) - result.root_scores.begin());
+        result.placement = static_cast<int32_t>(best);
+        result.value = static_cast<float>(value_sums[best] / std::max(result.root_scores[best], 1.0f));
+    }
+    return result;
+}
+
+void TetrisPlanner::runMcts(WorkerScratch& worker, const GameState& root, int simulations) {
+    std::vector<MctsNode>& tree = worker.tree;
+    tree.clear();
+    tree.push_back(MctsNode{root, 0.0f, 0.0f, 0.0f, 0, 0, 0, 0, false, root.game_over});
+    worker.q_min = std::numeric_limits<float>::infinity();
+    worker.q_max = -std::numeric_limits<float>::infinity();
+
+    auto child_q = [&](const MctsNode& child) {
+        return child.reward + config_.discount * (child.visits ? child.value_sum / child.visits : child.value);
+    };
+
+    for (int s = 0; s < simulations; s++) {
+        worker.path.clear();
+        uint32_t index = 0;
+        worker.path.push_back(index);
+
+        // Selection: UCT over min-max normalised Q; unvisited children start
+        // from their evaluator value rather than infinity
+        while (tree[index].expanded && tree[index].num_children > 0 &&
+               static_cast<int>(worker.path.size()) <= config_.depth) {
+            const MctsNode& node = tree[index];
+            const float range = worker.q_max > worker.q_min ? worker.q_max - worker.q_min : 1.0f;
+            const float explore = config_.exploration * std::sqrt(static_cast<float>(node.visits + 1));
+            uint32_t best = node.first_child;
+            float best_score = -std::numeric_limits<float>::infinity();
+            for (uint32_t c = node.first_child; c < node.first_child + node.num_children; c++) {
+                const MctsNode& child = tree[c];
+                const float score = (child_q(child) - worker.q_min) / range + explore / (1.0f + child.visits);
+                if (score > best_score) {
+                    best_score = score;
+                    best = c;
+                }
+            }
+            index = best;
+            worker.path.push_back(index);
+        }
+
+        // Expansion: a fresh leaf inside the horizon is expanded and valued
+        // by its best child; otherwise its own estimate stands
+        float value = tree[index].value;
+        if (tree[index].terminal) {
+            value = config_.terminal_value;
+        } else if (!tree[index].expanded && static_cast<int>(worker.path.size()) <= config_.depth) {
+            expandMcts(worker, index);
+            const MctsNode& node = tree[index];
+            if (node.num_children == 0) {
+                value = config_.terminal_value;
+            } else {
+                value = -std::numeric_limits<float>::infinity();
+                for (uint32_t c = node.first_child; c < node.first_child + node.num_children; c++) {
+                    value = std::max(value, child_q(tree[c]));
+                }
+            }
+        }
+
+        // Backup: V(parent afterstate) = r + gamma * V(child afterstate)
+        for (size_t p = worker.path.size(); p-- > 0;) {
+            MctsNode& node = tree[worker.path[p]];
+            node.visits++;
+            node.value_sum += value;
+            if (p > 0) {
+                const float q = child_q(node);
+                worker.q_min = std::min(worker.q_min, q);
+                worker.q_max = std::max(worker.q_max, q);
+            }
+            value = node.reward + config_.discount * value;
+        }
+    }
+}
+
+void TetrisPlanner::expandMcts(WorkerScratch& worker, uint32_t node_index) {
+    worker.rows.clear();
+    const GameState state = worker.tree[node_index].state;
+    const size_t count = expandChildren(worker, state);
+    worker.values.resize(count);
+    evaluate(worker.rows.data(), count, worker.values.data());
+
+    std::vector<MctsNode>& tree = worker.tree;
+    const uint32_t first = static_cast<uint32_t>(tree.size());
+    for (size_t c = 0; c < count; c++) {
+        const Child& child = worker.children[c];
+        const float value = child.terminal ? config_.terminal_value : worker.values[c];
+        tree.push_back(MctsNode{child.state, child.reward, value, 0.0f, 0, 0, 0,
+                                static_cast<uint16_t>(c), false, child.terminal});
+        const float q = child.reward + config_.discount * value;
+        worker.q_min = std::min(worker.q_min, q);
+        worker.q_max = std::max(worker.q_max, q);
+    }
+    MctsNode& node = tree[node_index];
+    node.first_child = first;
+    node.num_children = static_cast<uint16_t>(count);
+    node.expanded = true;
+    node.terminal = count == 0;  // nowhere left to put the piece
+}
@@ -0,0 +1,137 @@
+/* Queue throughput as thread counts grow: the collector's MpmcQueue against
+ * the mutex + condition_variable std::queue it replaced.
+ *
+ *   queue_bench [--threads T] [--ops N] [--capacity C]
+ *
+ * Each round runs k producers and k consumers (k = 1, 2, 4, ... T) moving N
+ * items in total through one queue of capacity C, and reports push+pop
+ * pairs per second.
+ * */
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "mpmcQueue.h"
+
+struct Options {
+    uint32_t threads = std::max(1u, std::thread::hardware_concurrency());
+    uint64_t ops = 2000000;
+    size_t capacity = 64;
+};
+
+bool parse_options(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; i++) {
+        const bool has_value = i + 1 < argc;
+        if (std::strcmp(argv[i], "--threads") == 0 && has_value) {
+            options.threads = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--ops") == 0 && has_value) {
+            options.ops = std::max(1ull, std::strtoull(argv[++i], nullptr, 10));
+        } else if (std::strcmp(argv[i], "--capacity") == 0 && has_value) {
+            options.capacity = std::max(1ul, std::strtoul(argv[++i], nullptr, 10));
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// What the collector used before MpmcQueue, bounded the same way
+class LockedQueue {
+public:
+    explicit LockedQueue(size_t capacity) : capacity_(capacity) {}
+
+    void push(uint64_t value) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_full_.wait(lock, [&] { return items_.size() < capacity_; });
+            items_.push(value);
+        }
+        not_empty_.notify_one();
+    }
+
+    void pop(uint64_t& out) {
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            not_empty_.wait(lock, [&] { return !items_.empty(); });
+            out = items_.front();
+            items_.pop();
+        }
+        not_full_.notify_one();
+    }
+
+private:
+    const size_t capacity_;
+    std::queue<uint64_t> items_;
+    std::mutex mutex_;
+    std::condition_variable not_full_;
+    std::condition_variable not_empty_;
+};
+
+// Items are 1..ops; returns pairs per second, or 0 if the checksum is off
+template <typename Queue>
+double run(Queue& queue, uint32_t pairs, uint64_t ops) {
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> sums(pairs, 0);
+    const auto start = std::chrono::steady_clock::now();
+    for (uint32_t t = 0; t < pairs; t++) {
+        const uint64_t begin = ops * t / pairs;
+        const uint64_t end = ops * (t + 1) / pairs;
+        threads.emplace_back([&queue, begin, end] {
+            for (uint64_t i = begin; i < end; i++) {
+                queue.push(i + 1);
+            }
+        });
+        threads.emplace_back([&queue, &sums, t, count = end - begin] {
+            uint64_t value = 0;
+            for (uint64_t i = 0; i < count; i++) {
+                queue.pop(value);
+                sums[t] += value;
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+    uint64_t sum = 0;
+    for (uint64_t s : sums) {
+        sum += s;
+    }
+    return sum == ops * (ops + 1) / 2 ? static_cast<double>(ops) / seconds : 0.0;
+}
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parse_options(argc, argv, options)) {
+        std::cerr << "usage: " << argv[0] << " [--threads T] [--ops N] [--capacity C]" << std::endl;
+        return 1;
+    }
+
+    std::cout << "capacity " << options.capacity << ", " << options.ops << " items per round\n";
+    std::cout << std::setw(8) << "pairs" << std::setw(16) << "mpmc ops/s" << std::setw(16) << "locked ops/s"
+              << std::setw(10) << "speedup" << "\n";
+    std::cout << std::fixed;
+    for (uint32_t pairs = 1; pairs <= options.threads; pairs *= 2) {
+        MpmcQueue<uint64_t> mpmc(options.capacity);
+        LockedQueue locked(mpmc.capacity());
+        const double mpmc_rate = run(mpmc, pairs, options.ops);
+        const double locked_rate = run(locked, pairs, options.ops);
+        if (mpmc_rate == 0.0 || locked_rate == 0.0) {
+            std::cerr << "checksum mismatch with " << pairs << " pairs" << std::endl;
+            return 1;
+        }
+        std::cout << std::setw(8) << pairs << std::setw(16) << std::setprecision(0) << mpmc_rate << std::setw(16)
+                  << locked_rate << std::setw(10) << std::setprecision(2) << mpmc_rate / locked_rate << "\n";
+    }
+    return 0;
+}
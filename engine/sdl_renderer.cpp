@@ -161,7 +161,7 @@ namespace SDLRenderer {
         }
     }
     
-    void drawPreviewPiece(const std::vector<std::vector<uint8_t>>& preview, 
+    void drawPreviewPiece(const GridView<uint8_t>& preview, 
                          int startX, int startY, const char* label) {
         if (font) {
             drawText(label, startX, startY - 25);
@@ -242,7 +242,7 @@ namespace SDLRenderer {
         // Draw next piece (only first piece from queue - first 4 rows)
         int nextX = 500;
         int nextY = 150;
-        std::vector<std::vector<uint8_t>> nextPiece(obs.queue.begin(), obs.queue.begin() + 4);
+        GridView<uint8_t> nextPiece{obs.queue.data, 4, obs.queue.cols};
         drawPreviewPiece(nextPiece, nextX, nextY, "NEXT:");
         
         // Draw hold piece
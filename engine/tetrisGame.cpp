@@ -1,18 +1,198 @@
 #include "tetrisGame.h"
 #include "pieces.h"
+#include "pieceTables.h"
 #include "constants.h"
 #include "input.h"
 #include "renderer.h"
+#include "stepRules.h"
+#include <algorithm>
 #include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
 #include <random>
+#include <stdexcept>
+#include <string>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
 
-TetrisGame::TetrisGame(TimeManager::Mode m, uint8_t queue_size, uint32_t seed)
-    : tm(TimeManager(m)), queue_size(queue_size), score(0), game_over(false), rng_(seed) {
-    obs.board.resize(Observation::BoardH, std::vector<uint8_t>(Observation::BoardW, 0));
-    obs.active_tetromino.resize(Observation::BoardH, std::vector<uint8_t>(Observation::BoardW, 0));
-    obs.holder.resize(Tetris::PIECE_SIZE, std::vector<uint8_t>(Tetris::PIECE_SIZE, 0));
-    obs.queue.resize(queue_size * Tetris::PIECE_SIZE, std::vector<uint8_t>(Tetris::PIECE_SIZE, 0));
+static_assert(Tetris::BOARD_HEIGHT - 1 + Tetris::PIECE_SIZE <= Observation::BoardH,
+              "spawned pieces must fit inside the observation board");
+
+
+Observation::Observation(int queue_size) {
+    allocate(queue_size * Tetris::PIECE_SIZE);
+}
+
+Observation::Observation(const Observation& other) {
+    allocate(other.queue.rows);
+    if (other.buffer_) {
+        std::memcpy(buffer_.get(), other.buffer_.get(), size_);
+    }
+}
+
+Observation::Observation(Observation&& other) noexcept
+    : active_tetromino(other.active_tetromino),
+      board(other.board),
+      holder(other.holder),
+      queue(other.queue),
+      buffer_(std::move(other.buffer_)),
+      size_(other.size_) {
+    other.active_tetromino = other.board = other.holder = other.queue = GridView<uint8_t>{};
+    other.size_ = 0;
+}
+
+Observation& Observation::operator=(const Observation& other) {
+    if (this != &other) {
+        if (!buffer_ || size_ != other.size_) {
+            allocate(other.queue.rows);
+        }
+        if (other.buffer_) {
+            std::memcpy(buffer_.get(), other.buffer_.get(), size_);
+        }
+    }
+    return *this;
+}
+
+Observation& Observation::operator=(Observation&& other) noexcept {
+    if (this != &other) {
+        active_tetromino = other.active_tetromino;
+        board = other.board;
+        holder = other.holder;
+        queue = other.queue;
+        buffer_ = std::move(other.buffer_);
+        size_ = other.size_;
+        other.active_tetromino = other.board = other.holder = other.queue = GridView<uint8_t>{};
+        other.size_ = 0;
+    }
+    return *this;
+}
+
+void Observation::AlignedDelete::operator()(uint8_t* ptr) const {
+    ::operator delete[](ptr, std::align_val_t(Alignment));
+}
+
+void Observation::allocate(int queue_rows) {
+    const size_t board_cells = static_cast<size_t>(BoardH) * BoardW;
+    const size_t holder_cells = static_cast<size_t>(Tetris::PIECE_SIZE) * Tetris::PIECE_SIZE;
+    size_ = 2 * board_cells + holder_cells + static_cast<size_t>(queue_rows) * Tetris::PIECE_SIZE;
+
+    // Round the allocation up to whole cache lines
+    const size_t bytes = (size_ + Alignment - 1) / Alignment * Alignment;
+    buffer_.reset(static_cast<uint8_t*>(::operator new[](bytes, std::align_val_t(Alignment))));
+    std::memset(buffer_.get(), 0, bytes);
+
+    uint8_t* ptr = buffer_.get();
+    active_tetromino = GridView<uint8_t>{ptr, BoardH, BoardW};
+    board = GridView<uint8_t>{ptr + board_cells, BoardH, BoardW};
+    holder = GridView<uint8_t>{ptr + 2 * board_cells, Tetris::PIECE_SIZE, Tetris::PIECE_SIZE};
+    queue = GridView<uint8_t>{ptr + 2 * board_cells + holder_cells, queue_rows, Tetris::PIECE_SIZE};
+}
+
+namespace {
+
+constexpr size_t ObsBoardCells = static_cast<size_t>(Observation::BoardH) * Observation::BoardW;
+constexpr size_t ObsPieceCells = static_cast<size_t>(Tetris::PIECE_SIZE) * Tetris::PIECE_SIZE;
+
+// Both plane sizes are whole multiples of 16 cells, so no partial bytes
+static_assert(ObsBoardCells % 16 == 0 && ObsPieceCells % 16 == 0, "packed planes must be whole bytes");
+
+// 0/1 cells to bits, 8 per byte, first cell in the low bit
+void packBits(const uint8_t* src, size_t count, uint8_t* dest) {
+    size_t i = 0;
+#if defined(__SSE2__)
+    const __m128i zero = _mm_setzero_si128();
+    for (; i + 16 <= count; i += 16) {
+        const __m128i cells = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        const int bits = _mm_movemask_epi8(_mm_cmpgt_epi8(cells, zero));
+        dest[i / 8] = static_cast<uint8_t>(bits);
+        dest[i / 8 + 1] = static_cast<uint8_t>(bits >> 8);
+    }
+#endif
+    for (; i < count; i += 8) {
+        uint8_t byte = 0;
+        for (int k = 0; k < 8; k++) {
+            byte |= static_cast<uint8_t>((src[i + k] != 0) << k);
+        }
+        dest[i / 8] = byte;
+    }
+}
+
+// Float expansions of every packed byte, so unpacking is table copies
+struct UnpackTables {
+    float bits[256][8];
+    float nibbles[256][2];
+};
+
+constexpr UnpackTables makeUnpackTables() {
+    UnpackTables t{};
+    for (int b = 0; b < 256; b++) {
+        for (int k = 0; k < 8; k++) {
+            t.bits[b][k] = static_cast<float>((b >> k) & 1);
+        }
+        t.nibbles[b][0] = static_cast<float>(b & 0xF);
+        t.nibbles[b][1] = static_cast<float>(b >> 4);
+    }
+    return t;
+}
+
+constexpr UnpackTables UNPACK = makeUnpackTables();
+
+}  // namespace
+
+size_t Observation::packedSize(int queue_size) {
+    return ObsBoardCells / 8 + ObsBoardCells / 2 + (1 + static_cast<size_t>(queue_size)) * ObsPieceCells / 8;
+}
+
+size_t Observation::pack(uint8_t* dest) const {
+    return pack(data(), queue.rows / Tetris::PIECE_SIZE, dest);
+}
+
+size_t Observation::pack(const uint8_t* src, int queue_size, uint8_t* dest) {
+    uint8_t* out = dest;
+    packBits(src, ObsBoardCells, out);
+    out += ObsBoardCells / 8;
+
+    const uint8_t* cells = src + ObsBoardCells;
+    for (size_t i = 0; i < ObsBoardCells / 2; i++) {
+        out[i] = static_cast<uint8_t>(cells[2 * i] | (cells[2 * i + 1] << 4));
+    }
+    out += ObsBoardCells / 2;
+
+    const size_t piece_cells = (1 + static_cast<size_t>(queue_size)) * ObsPieceCells;
+    packBits(src + 2 * ObsBoardCells, piece_cells, out);
+    out += piece_cells / 8;
+    return static_cast<size_t>(out - dest);
+}
+
+void Observation::unpack(const uint8_t* src, size_t count, int queue_size, float* dest) {
+    const size_t piece_bytes = (1 + static_cast<size_t>(queue_size)) * ObsPieceCells / 8;
+    for (size_t n = 0; n < count; n++) {
+        for (size_t i = 0; i < ObsBoardCells / 8; i++) {
+            std::memcpy(dest, UNPACK.bits[*src++], sizeof(UNPACK.bits[0]));
+            dest += 8;
+        }
+        for (size_t i = 0; i < ObsBoardCells / 2; i++) {
+            std::memcpy(dest, UNPACK.nibbles[*src++], sizeof(UNPACK.nibbles[0]));
+            dest += 2;
+        }
+        for (size_t i = 0; i < piece_bytes; i++) {
+            std::memcpy(dest, UNPACK.bits[*src++], sizeof(UNPACK.bits[0]));
+            dest += 8;
+        }
+    }
+}
+
+TetrisGame::TetrisGame(TimeManager::Mode m, uint8_t queue_size, uint32_t seed, PieceRandomizer randomizer)
+    : score(0), scored(0), game_over(false), queue_size(queue_size), tm(TimeManager(m)), pieces(seed, randomizer),
+      compat_rng(seed), obs(queue_size), queue_dirty(true), active_rendered(false), rendered_holder(0xFF),
+      feature_cols_dirty(0) {
+    clearBoard();
+    // At most one line per piece row can clear at once; reserving here keeps
+    // step() free of heap allocations.
+    clearing_lines.reserve(Tetris::PIECE_SIZE);
 
     // Initialize queue with random pieces
     queue.resize(queue_size);
@@ -24,9 +204,9 @@ TetrisGame::TetrisGame(TimeManager::Mode m, uint8_t queue_size, uint32_t seed)
     rotation = 0;
     queue_index = 0;
     holder_type = 7; // out of range meaning not populated
-    current_x = (Tetris::BOARD_WIDTH / 2);
-    current_y = Tetris::BOARD_HEIGHT - 1;
     current_piece_type = getNextPiece(); // pop from the queue
+    current_x = Tetris::PIECE_TABLE.spawn_x[current_piece_type];
+    current_y = Tetris::PIECE_TABLE.spawn_y[current_piece_type];
 
     if (checkCollision()) {
         game_over = true; 
@@ -36,28 +216,232 @@ TetrisGame::TetrisGame(TimeManager::Mode m, uint8_t queue_size, uint32_t seed)
     updateActiveMask();
 }
 
-uint8_t TetrisGame::samplePiece() {
-    static constexpr int MaxPiece = 6;
-    std::uniform_int_distribution<int> dist(0, MaxPiece);
-    return static_cast<uint8_t>(dist(rng_));
+void TetrisGame::clearBoard() {
+    for (int y = 0; y < Observation::BoardH; y++) {
+        board_rows[y] = EmptyRow;
+    }
+    std::memset(board_cells, 0, sizeof(board_cells));
+    std::memset(column_heights, 0, sizeof(column_heights));
+    board_dirty_lo = 0;
+    board_dirty_hi = Observation::BoardH - 1;
+    feature_rows_lo = 0;
+    feature_rows_hi = Tetris::BOARD_HEIGHT - 1;
+    markFeatureColumns(0, Tetris::BOARD_WIDTH - 1);
 }
 
-void TetrisGame::reset() {
-    // Clear the board
-    for (int y = 0; y < Observation::BoardH; y++) {
-        for (int x = 0; x < Observation::BoardW; x++) {
-            obs.board[y][x] = 0;
-            obs.active_tetromino[y][x] = 0;
+void TetrisGame::markBoardRows(int lo, int hi) {
+    if (lo < board_dirty_lo) board_dirty_lo = static_cast<int8_t>(lo);
+    if (hi > board_dirty_hi) board_dirty_hi = static_cast<int8_t>(hi);
+    // Features only look at the visible rows
+    if (lo < Tetris::BOARD_HEIGHT) {
+        hi = std::min(hi, Tetris::BOARD_HEIGHT - 1);
+        if (lo < feature_rows_lo) feature_rows_lo = static_cast<int8_t>(lo);
+        if (hi > feature_rows_hi) feature_rows_hi = static_cast<int8_t>(hi);
+    }
+}
+
+void TetrisGame::markFeatureColumns(int lo, int hi) {
+    lo = std::max(lo, 0);
+    hi = std::min(hi, Tetris::BOARD_WIDTH - 1);
+    if (lo <= hi) {
+        feature_cols_dirty |= static_cast<uint16_t>(((1u << (hi - lo + 1)) - 1) << lo);
+    }
+}
+
+void TetrisGame::setCell(int x, int y, uint8_t value) {
+    if (x < 0 || x >= Tetris::BOARD_WIDTH || y < 0 || y >= Observation::BoardH) {
+        return;
+    }
+    markBoardRows(y, y);
+    markFeatureColumns(x, x);
+    Rules::setCell(board_rows, &board_cells[0][0], column_heights, x, y, value);
+}
+
+uint8_t TetrisGame::columnHeightBelow(int x, int top) const {
+    return Rules::columnHeightBelow(board_rows, x, top);
+}
+
+int TetrisGame::getGhostY() {
+    return landingY(current_piece_type, current_x, current_y, rotation);
+}
+
+int TetrisGame::landingY(uint8_t type, int x, int y, uint8_t rot) const {
+    return Rules::landingY(board_rows, column_heights, type, x, y, rot);
+}
+
+uint8_t TetrisGame::getCell(int x, int y) const {
+    if (x < 0 || x >= Tetris::BOARD_WIDTH || y < 0 || y >= Observation::BoardH) {
+        return 0;
+    }
+    return board_cells[y][x];
+}
+
+const BoardFeatures& TetrisGame::getFeatures() {
+    refreshFeatures();
+    return features;
+}
+
+namespace {
+
+// Walls are set in every row, so transitions at the edges count too
+constexpr uint16_t RowTransitionMask = static_cast<uint16_t>(
+    ((1u << (Tetris::BOARD_WIDTH + 1)) - 1) << (TetrisGame::BoardWall - 1));
+
+uint8_t rowTransitions(uint16_t row) {
+    const unsigned bits = row;
+    return static_cast<uint8_t>(__builtin_popcount((bits ^ (bits >> 1)) & RowTransitionMask));
+}
+
+// Holes and column transitions of column x up to its (visible) height
+void scanColumn(const uint16_t* rows, int x, int height, BoardFeatures& f) {
+    const uint16_t bit = static_cast<uint16_t>(1u << (x + TetrisGame::BoardWall));
+    uint8_t holes = 0;
+    uint8_t transitions = 0;
+    bool prev_filled = true;  // floor
+    for (int y = 0; y < height; y++) {
+        const bool filled = (rows[y] & bit) != 0;
+        holes += !filled;
+        transitions += filled != prev_filled;
+        prev_filled = filled;
+    }
+    // The top cell against the empty rows above it
+    if (height < Tetris::BOARD_HEIGHT) {
+        transitions += prev_filled;
+    }
+    f.heights[x] = static_cast<uint8_t>(height);
+    f.holes[x] = holes;
+    f.column_transitions[x] = transitions;
+}
+
+// Wells and totals from the per-column values
+void finishFeatures(BoardFeatures& f, int row_transitions) {
+    f.aggregate_height = 0;
+    f.max_height = 0;
+    f.total_holes = 0;
+    f.bumpiness = 0;
+    f.total_column_transitions = 0;
+    f.cumulative_wells = 0;
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+        const int height = f.heights[x];
+        const int left = x > 0 ? f.heights[x - 1] : Tetris::BOARD_HEIGHT;
+        const int right = x + 1 < Tetris::BOARD_WIDTH ? f.heights[x + 1] : Tetris::BOARD_HEIGHT;
+        const int well = std::max(std::min(left, right) - height, 0);
+        f.wells[x] = static_cast<uint8_t>(well);
+        f.cumulative_wells += well * (well + 1) / 2;
+        f.aggregate_height += height;
+        f.max_height = std::max(f.max_height, height);
+        f.total_holes += f.holes[x];
+        f.total_column_transitions += f.column_transitions[x];
+        if (x + 1 < Tetris::BOARD_WIDTH) {
+            f.bumpiness += std::abs(height - f.heights[x + 1]);
         }
     }
-    ;
-    
-    // Clear holder 
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-            obs.holder[y][x] = 0;
+    f.row_transitions = row_transitions;
+}
+
+}  // namespace
+
+void TetrisGame::refreshFeatures() {
+    if (feature_cols_dirty == 0 && feature_rows_lo > feature_rows_hi) {
+        return;
+    }
+
+    for (int y = feature_rows_lo; y <= feature_rows_hi; y++) {
+        row_transitions[y] = rowTransitions(board_rows[y]);
+    }
+    feature_rows_lo = Tetris::BOARD_HEIGHT;
+    feature_rows_hi = -1;
+
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+        if (feature_cols_dirty & (1u << x)) {
+            // Cells locked above the visible rows don't count
+            const int height = column_heights[x] <= Tetris::BOARD_HEIGHT
+                                   ? column_heights[x]
+                                   : columnHeightBelow(x, Tetris::BOARD_HEIGHT);
+            scanColumn(board_rows, x, height, features);
         }
     }
+    feature_cols_dirty = 0;
+
+    // Totals are cheap next to the per-column scans, so redo them all
+    int total_row_transitions = 0;
+    for (int y = 0; y < Tetris::BOARD_HEIGHT; y++) {
+        total_row_transitions += row_transitions[y];
+    }
+    finishFeatures(features, total_row_transitions);
+}
+
+BoardFeatures TetrisGame::computeFeatures(const uint16_t* rows) {
+    BoardFeatures f{};
+    int total_row_transitions = 0;
+    for (int y = 0; y < Tetris::BOARD_HEIGHT; y++) {
+        total_row_transitions += rowTransitions(rows[y]);
+    }
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+        const uint16_t bit = static_cast<uint16_t>(1u << (x + BoardWall));
+        int height = Tetris::BOARD_HEIGHT;
+        while (height > 0 && !(rows[height - 1] & bit)) {
+            height--;
+        }
+        scanColumn(rows, x, height, f);
+    }
+    finishFeatures(f, total_row_transitions);
+    return f;
+}
+
+size_t TetrisGame::featureSize(int queue_size) {
+    static constexpr int NumTypes = Tetris::NUM_PIECES;
+    return BoardFeatureCount +                        // heights, wells, totals
+           NumTypes + Tetris::NUM_ROTATIONS + 2 +     // current piece, rotation, x, y
+           NumTypes + static_cast<size_t>(queue_size) * NumTypes;  // holder, queue
+}
+
+size_t TetrisGame::writeBoardFeatures(const BoardFeatures& f, float* dest) {
+    float* out = dest;
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) *out++ = f.heights[x];
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) *out++ = f.wells[x];
+    *out++ = static_cast<float>(f.aggregate_height);
+    *out++ = static_cast<float>(f.max_height);
+    *out++ = static_cast<float>(f.total_holes);
+    *out++ = static_cast<float>(f.bumpiness);
+    *out++ = static_cast<float>(f.row_transitions);
+    *out++ = static_cast<float>(f.total_column_transitions);
+    *out++ = static_cast<float>(f.cumulative_wells);
+    return static_cast<size_t>(out - dest);
+}
+
+size_t TetrisGame::writeAfterstate(const Placement& placement, float* dest) {
+    dest[0] = static_cast<float>(placement.lines_cleared);
+    return 1 + writeBoardFeatures(placement.features, dest + 1);
+}
+
+size_t TetrisGame::writeFeatures(float* dest) {
+    float* out = dest + writeBoardFeatures(getFeatures(), dest);
+
+    auto one_hot = [&out](int value, int count) {
+        for (int i = 0; i < count; i++) {
+            *out++ = i == value ? 1.0f : 0.0f;
+        }
+    };
+    one_hot(current_piece_type, Tetris::NUM_PIECES);
+    one_hot(rotation, Tetris::NUM_ROTATIONS);
+    *out++ = static_cast<float>(current_x);
+    *out++ = static_cast<float>(current_y);
+    one_hot(holder_type, Tetris::NUM_PIECES);  // all zero while empty
+    for (int i = 0; i < queue_size; i++) {
+        one_hot(queue[(queue_index + i) % queue_size], Tetris::NUM_PIECES);
+    }
+    return static_cast<size_t>(out - dest);
+}
+
+const Observation& TetrisGame::getObservation() {
+    refreshObservation();
+    return obs;
+}
+
+void TetrisGame::reset() {
+    // Clear the board
+    clearBoard();
     
     // Reset game state
     score = 0;
@@ -71,18 +455,80 @@ void TetrisGame::reset() {
         queue[i] = samplePiece();
     }
     queue_index = 0;
+    queue_dirty = true;
     
     // Spawn first piece
     rotation = 0;
-    current_x = (Tetris::BOARD_WIDTH / 2);
-    current_y = Tetris::BOARD_HEIGHT - 1;
     current_piece_type = getNextPiece();
+    current_x = Tetris::PIECE_TABLE.spawn_x[current_piece_type];
+    current_y = Tetris::PIECE_TABLE.spawn_y[current_piece_type];
     
     if (checkCollision()) {
         game_over = true;
     }
-    
-    updateObservation();
+}
+
+GameState TetrisGame::snapshot() const {
+    if (queue_size > GameState::MaxQueue) {
+        throw std::invalid_argument("snapshots support queue_size up to " + std::to_string(GameState::MaxQueue));
+    }
+    if (pieces.randomizer == PieceRandomizer::COMPAT) {
+        throw std::invalid_argument("COMPAT games cannot be snapshotted");
+    }
+    GameState state{};
+    std::memcpy(state.board_rows, board_rows, sizeof(board_rows));
+    for (int y = 0; y < Observation::BoardH; y++) {
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x += 2) {
+            state.board_cells[y][x / 2] = static_cast<uint8_t>(board_cells[y][x] | (board_cells[y][x + 1] << 4));
+        }
+    }
+    state.pieces = pieces;
+    state.score = score;
+    state.queue_size = static_cast<uint8_t>(queue_size);
+    std::copy_n(queue.begin(), state.queue_size, state.queue);
+    state.queue_index = queue_index;
+    state.holder_type = holder_type;
+    state.current_x = current_x;
+    state.current_y = current_y;
+    state.current_piece_type = current_piece_type;
+    state.rotation = rotation;
+    state.game_over = game_over;
+    return state;
+}
+
+bool TetrisGame::restore(const GameState& state) {
+    if (state.queue_size != queue_size) {
+        return false;
+    }
+    std::memcpy(board_rows, state.board_rows, sizeof(board_rows));
+    for (int y = 0; y < Observation::BoardH; y++) {
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x += 2) {
+            board_cells[y][x] = state.board_cells[y][x / 2] & 0xF;
+            board_cells[y][x + 1] = state.board_cells[y][x / 2] >> 4;
+        }
+    }
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+        column_heights[x] = columnHeightBelow(x, Observation::BoardH);
+    }
+    pieces = state.pieces;
+    score = state.score;
+    scored = 0;
+    std::copy_n(state.queue, queue_size, queue.begin());
+    queue_index = state.queue_index;
+    holder_type = state.holder_type;
+    current_x = state.current_x;
+    current_y = state.current_y;
+    current_piece_type = state.current_piece_type;
+    rotation = state.rotation;
+    game_over = state.game_over;
+    clearing_lines.clear();
+    placements.clear();
+
+    // Everything derived from the board is stale
+    markBoardRows(0, Observation::BoardH - 1);
+    markFeatureColumns(0, Tetris::BOARD_WIDTH - 1);
+    queue_dirty = true;
+    return true;
 }
 
 // get val from queue
@@ -96,6 +542,7 @@ uint8_t TetrisGame::getNextPiece() {
     uint8_t next_piece = queue[queue_index];
     queue[queue_index] = samplePiece();
     queue_index = (queue_index + 1) % queue_size;
+    queue_dirty = true;
     return next_piece;
 }
 
@@ -103,180 +550,105 @@ uint8_t TetrisGame::setLastPiece(uint8_t val) {
     // update tetris game variables
     queue_index = (queue_index - 1 + queue_size) % queue_size;
     queue[queue_index] = val;
+    queue_dirty = true;
     // For now, return random piece (0-6)
     return val;
 }
 
 void TetrisGame::updateActiveMask() {
     // update active mask based on current piece type and rotation
-    for (int i = 0; i < Tetris::PIECE_SIZE; i++) {
-        for (int j = 0; j < Tetris::PIECE_SIZE; j++) {
-            if (current_piece_type == 0) {
-                obs.active_tetromino[current_y + i][current_x + j] =
-                    Tetris::PIECES[current_piece_type][rotation][i][j];
-            }
+    const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[current_piece_type][rotation];
+    for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+        int board_y = current_y + shape.cell_y[i];
+        int board_x = current_x + shape.cell_x[i];
+        if (board_y >= 0 && board_y < Observation::BoardH &&
+            board_x >= 0 && board_x < Observation::BoardW) {
+            obs.active_tetromino[board_y][board_x] = 1;
         }
     }
 }
 
 void TetrisGame::applyAction(uint8_t action) {
-    // LEFT, RIGHT, DOWN, CW, CCW, DROP, SWAP, NOOP
-    // need to transform the current tetrimino
-    int old_x = current_x;
-    int old_y = current_y;
-    uint8_t old_rotation = rotation;
-    
-    switch(action) {
-        case Action::LEFT:
-            current_x -= 1;
-            if (checkCollision()) {
-                current_x = old_x;  // Revert if collision
-            }
-            break;
-        case Action::RIGHT:
-            current_x += 1;
-            if (checkCollision()) {
-                current_x = old_x;  // Revert if collision
-            }
-            break;
-        case Action::DOWN:
-            current_y -= 1;
-            if (checkCollision()) {
-                current_y = old_y;  // Revert if collision
-            }
-            break;
-        case Action::CW:
-            rotation = (rotation + 1) % 4;
-            if (checkCollision()) {
-                rotation = old_rotation;  // Revert if collision
-            }
-            break;
-        case Action::CCW:
-            rotation = (rotation - 1 + 4) % 4;
-            if (checkCollision()) {
-                rotation = old_rotation;  // Revert if collision
-            }
-            break;
-        case Action::DROP:
-            while (!checkCollision()) {
-                current_y -= 1;
-            }
-            current_y += 1;  // Back up to last valid position
-            // Lock the piece immediately after hard drop
-            lockPiece();
-            scored = clearLines();
-            score += scored;
-            spawnPiece();
-            if (checkCollision()) {
-                game_over = true;
-            }
-            break;
-        case Action::SWAP:
-            // Swap with hold piece
-            if (holder_type == 7) {
-                // No piece in holder, just move current piece there
-                holder_type = current_piece_type;
-                current_piece_type = getNextPiece();
-                current_x = (Tetris::BOARD_WIDTH / 2);
-                current_y = Tetris::BOARD_HEIGHT - 1;
-                rotation = 0;
-            } else {
-                // Swap with held piece
-                uint8_t temp = current_piece_type;
-                current_piece_type = holder_type;
-                holder_type = temp;
-                current_x = (Tetris::BOARD_WIDTH / 2);
-                current_y = Tetris::BOARD_HEIGHT - 1;
-                rotation = 0;
-            }
-            if (checkCollision()) {
-                // Can't swap - revert (shouldn't happen in normal play)
-                game_over = true;
-            }
-            break;
-        default:
-            // invalid action or NOOP
-            break;
-    }
+    StepRules::applyAction(*this, action);
 }
 
 void TetrisGame::updateGameState() {
-    // need to lock piece and clear lines if we have reached a point of no return
-    current_y -= 1;
-    if (checkCollision()) {
-        current_y += 1;  // Restore position before locking
-        // lock piece
-        lockPiece();
-        // clear lines
-        scored = clearLines();
-        score += scored;
-        // spawn new piece
-        spawnPiece();
-        if (checkCollision()) {
-            game_over = true;
-        }
-    }
+    StepRules::applyGravity(*this);
 }
 
 void TetrisGame::updateObservation() {
-    // Clear active_tetromino first
-    for (int y = 0; y < Observation::BoardH; y++) {
-        for (int x = 0; x < Observation::BoardW; x++) {
-            obs.active_tetromino[y][x] = 0;
-        }
+    // Forget what was rendered so every plane is rewritten
+    markBoardRows(0, Observation::BoardH - 1);
+    queue_dirty = true;
+    active_rendered = false;
+    rendered_holder = 0xFF;
+    refreshObservation();
+}
+
+void TetrisGame::refreshObservation() {
+    // Render the locked cells of the rows touched since the last refresh
+    for (int y = board_dirty_lo; y <= board_dirty_hi; y++) {
+        std::memcpy(obs.board[y].data, board_cells[y], Tetris::BOARD_WIDTH);
     }
+    board_dirty_lo = Observation::BoardH;
+    board_dirty_hi = -1;
 
-    // Update active_tetromino at current position
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-            if (Tetris::PIECES[current_piece_type][rotation][y][x]) {
-                int board_y = current_y + y;
-                int board_x = current_x + x;
+    // Update active_tetromino: erase the old footprint, draw the new one
+    if (!active_rendered || rendered_piece.x != current_x || rendered_piece.y != current_y ||
+        rendered_piece.type != current_piece_type || rendered_piece.rotation != rotation) {
+        auto paint = [&](const RenderedPiece& piece, uint8_t value) {
+            const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[piece.type][piece.rotation];
+            for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+                int board_y = piece.y + shape.cell_y[i];
+                int board_x = piece.x + shape.cell_x[i];
                 // Bounds check before writing
                 if (board_y >= 0 && board_y < Observation::BoardH &&
                     board_x >= 0 && board_x < Observation::BoardW) {
-                    obs.active_tetromino[board_y][board_x] = 1;
+                    obs.active_tetromino[board_y][board_x] = value;
                 }
             }
+        };
+        if (active_rendered) {
+            paint(rendered_piece, 0);
+        } else {
+            std::memset(obs.active_tetromino.data, 0,
+                        static_cast<size_t>(Observation::BoardH) * Observation::BoardW);
         }
+        rendered_piece = RenderedPiece{current_x, current_y, current_piece_type, rotation};
+        paint(rendered_piece, 1);
+        active_rendered = true;
     }
 
     // Update holder piece display
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-            if (holder_type < 7) {
-                obs.holder[y][x] = Tetris::PIECES[holder_type][0][y][x];
-            } else {
-                obs.holder[y][x] = 0;
+    if (rendered_holder != holder_type) {
+        for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
+            const uint8_t bits = holder_type < 7 ? Tetris::PIECE_TABLE.shapes[holder_type][0].rows[y] : 0;
+            for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
+                obs.holder[y][x] = (bits >> x) & 1;
             }
         }
+        rendered_holder = holder_type;
     }
 
     // Update queue display - show upcoming pieces
-    for (int i = 0; i < queue_size; i++) {
-        uint8_t piece_type = queue[(queue_index + i) % queue_size];
-        for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-            for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-                obs.queue[i * Tetris::PIECE_SIZE + y][x] = Tetris::PIECES[piece_type][0][y][x];
+    if (queue_dirty) {
+        for (int i = 0; i < queue_size; i++) {
+            uint8_t piece_type = queue[(queue_index + i) % queue_size];
+            for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
+                const uint8_t bits = Tetris::PIECE_TABLE.shapes[piece_type][0].rows[y];
+                for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
+                    obs.queue[i * Tetris::PIECE_SIZE + y][x] = (bits >> x) & 1;
+                }
             }
         }
+        queue_dirty = false;
     }
 }
 
 StepResult TetrisGame::step(int action) {
-    // This is the pattern
-    // apply action
-    applyAction(action);
-    // update gravity, mechanics, collision, lock, clear lines
-    updateGameState();
-    updateObservation();
-
-    // compute reward based on the above
-    return StepResult{
-        obs,
-        getReward(),
-        game_over
-    };
+    // There is no clear animation when stepping, so full lines go right
+    // after every lock. Left on the board they would score again later.
+    return StepRules::step(*this, action);
 }
 
 bool TetrisGame::isGameOver() {
@@ -289,97 +661,55 @@ float TetrisGame::getReward() {
 }
 
 bool TetrisGame::checkCollision() {
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-            if (Tetris::PIECES[current_piece_type][rotation][y][x]) {
-                int board_x = current_x + x;
-                int board_y = current_y + y;
-                
-                // Check boundaries - use actual playable board size
-                if (board_x < 0 || board_x >= Tetris::BOARD_WIDTH ||
-                    board_y < 0 || board_y >= Observation::BoardH) {
-                    return true;
-                }
-                
-                // Check collision with existing pieces
-                if (obs.board[board_y][board_x]) {
-                    return true;
-                }
-            }
-        }
-    }
-    return false;
+    return collidesAt(current_piece_type, current_x, current_y, rotation);
+}
+
+bool TetrisGame::collidesAt(uint8_t type, int x, int y, uint8_t rot) const {
+    return Rules::collides(board_rows, type, x, y, rot);
 }
 
 void TetrisGame::spawnPiece() {
-    // get next piece
-    current_piece_type = getNextPiece();
-    current_x = (Tetris::BOARD_WIDTH / 2);
-    current_y = Tetris::BOARD_HEIGHT - 1;
-    rotation = 0;
+    StepRules::spawnPiece(*this);
 }
 
 void TetrisGame::lockPiece() {
-    // lock piece (store piece_type + 1 so 0 remains empty)
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-            if (Tetris::PIECES[current_piece_type][rotation][y][x]) {
-                int board_y = current_y + y;
-                int board_x = current_x + x;
-                // Bounds check before writing
-                if (board_y >= 0 && board_y < Observation::BoardH &&
-                    board_x >= 0 && board_x < Observation::BoardW) {
-                    obs.board[board_y][board_x] = current_piece_type + 1;
-                }
-            }
-        }
-    }
+    // Cells are piece_type + 1 so 0 remains empty
+    const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[current_piece_type][rotation];
+    markBoardRows(std::max(current_y + shape.min_y, 0),
+                  std::min(current_y + shape.max_y, Observation::BoardH - 1));
+    markFeatureColumns(current_x + shape.min_x, current_x + shape.max_x);
+    Rules::lockPiece(board_rows, &board_cells[0][0], column_heights, current_piece_type, current_x, current_y,
+                     rotation);
 }
 
 int TetrisGame::clearLine(uint8_t row) {
-    // Shift all rows above down by one
-    for (int y = row; y < Tetris::BOARD_HEIGHT - 1; y++) {
-        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            obs.board[y][x] = obs.board[y + 1][x];
-        }
-    }
-    // Clear the top row
-    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-        obs.board[Tetris::BOARD_HEIGHT - 1][x] = 0;
+    if (row >= Tetris::BOARD_HEIGHT) {
+        return 0;
     }
+    markBoardRows(row, Tetris::BOARD_HEIGHT - 1);
+    markFeatureColumns(0, Tetris::BOARD_WIDTH - 1);
+    Rules::clearRow(board_rows, &board_cells[0][0], column_heights, row);
     return 1;
 }
 
 int TetrisGame::clearLines() {
+    // Rows the current piece covers; the actual clearing happens after the
+    // animation (completeClearLines)
     clearing_lines.clear();
-    
-    // Check rows where the current piece was placed
-    for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
-        int row = current_y + y;
-        if (row < 0 || row >= Tetris::BOARD_HEIGHT) continue;
-        
-        // Check if this row is full
-        bool is_full = true;
-        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            if (obs.board[row][x] == 0) {
-                is_full = false;
-                break;
-            }
-        }
-        
-        if (is_full) {
-            clearing_lines.push_back(row);
+    const unsigned full = Rules::fullRows(board_rows, current_y);
+    for (int r = 0; r < Tetris::PIECE_SIZE; r++) {
+        if (full & (1u << r)) {
+            clearing_lines.push_back(current_y + r);
         }
     }
-
-    // Return number of lines to clear (actual clearing happens after animation)
-    return clearing_lines.size();
+    return static_cast<int>(clearing_lines.size());
 }
 
 void TetrisGame::completeClearLines() {
-    // Actually clear the marked lines
-    for (int row : clearing_lines) {
-        clearLine(row);
+    // Actually clear the marked lines, topmost first so the rows still
+    // pending are not shifted out from under their indices
+    for (auto it = clearing_lines.rbegin(); it != clearing_lines.rend(); ++it) {
+        clearLine(*it);
     }
     clearing_lines.clear();
 }
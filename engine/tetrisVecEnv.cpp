@@ -0,0 +1,119 @@
+#include "tetrisVecEnv.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+TetrisVecEnv::TetrisVecEnv(size_t num_envs, uint8_t queue_size, uint32_t seed_base, PieceRandomizer randomizer,
+                           size_t num_threads, uint32_t max_episode_steps, ObsDtype obs_dtype)
+    : num_envs_(num_envs),
+      queue_size_(queue_size),
+      max_episode_steps_(max_episode_steps),
+      obs_dtype_(obs_dtype),
+      pool_(num_threads) {
+    if (num_envs == 0) {
+        throw std::invalid_argument("num_envs must be > 0");
+    }
+    if (queue_size == 0) {
+        throw std::invalid_argument("queue_size must be > 0");
+    }
+    obs_dim_ = Observation(queue_size).size();
+    stored_obs_dim_ = obs_dtype == ObsDtype::PACKED ? Observation::packedSize(queue_size) : obs_dim_;
+
+    if (obs_dtype == ObsDtype::FLOAT32) {
+        obs_float_.assign(num_envs * stored_obs_dim_, 0.0f);
+        final_float_.assign(num_envs * stored_obs_dim_, 0.0f);
+    } else {
+        obs_bytes_.assign(num_envs * stored_obs_dim_, 0);
+        final_bytes_.assign(num_envs * stored_obs_dim_, 0);
+    }
+    rewards_.assign(num_envs, 0.0f);
+    terminated_.assign(num_envs, 0);
+    truncated_.assign(num_envs, 0);
+    final_scores_.assign(num_envs, 0);
+    final_lengths_.assign(num_envs, 0);
+    lengths_.assign(num_envs, 0);
+
+    // Contiguous env ranges, one per worker; each is batched by its VecTetris
+    const size_t num_shards = std::min(num_envs, pool_.size());
+    shards_.resize(num_shards);
+    for (size_t s = 0; s < num_shards; s++) {
+        Shard& shard = shards_[s];
+        shard.begin = num_envs * s / num_shards;
+        const size_t count = num_envs * (s + 1) / num_shards - shard.begin;
+        shard.vec = std::make_unique<VecTetris>(count, queue_size, seed_base + static_cast<uint32_t>(shard.begin),
+                                                randomizer);
+        shard.cells.resize(obs_dim_);
+        // VecTetris starts its games already reset
+        for (size_t j = 0; j < count; j++) {
+            writeObservation(shard, j, false);
+        }
+    }
+}
+
+void TetrisVecEnv::reset(const uint32_t* seeds) {
+    pool_.parallelFor(shards_.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            Shard& shard = shards_[s];
+            for (size_t j = 0; j < shard.vec->size(); j++) {
+                const size_t env = shard.begin + j;
+                if (seeds) {
+                    shard.vec->piece_sources[j].reseed(seeds[env]);
+                }
+                shard.vec->reset(j);
+                lengths_[env] = 0;
+                rewards_[env] = 0.0f;
+                terminated_[env] = 0;
+                truncated_[env] = 0;
+                writeObservation(shard, j, false);
+            }
+        }
+    });
+}
+
+void TetrisVecEnv::step(const int32_t* actions) {
+    static_assert(sizeof(int32_t) == sizeof(int), "VecTetris::step takes int actions");
+    pool_.parallelFor(shards_.size(), [&](size_t, size_t begin, size_t end) {
+        for (size_t s = begin; s < end; s++) {
+            Shard& shard = shards_[s];
+            VecTetris& vec = *shard.vec;
+            vec.step(reinterpret_cast<const int*>(actions + shard.begin));
+
+            for (size_t j = 0; j < vec.size(); j++) {
+                const size_t env = shard.begin + j;
+                const uint32_t length = ++lengths_[env];
+                const bool term = vec.terminated()[j] != 0;
+                const bool trunc = !term && max_episode_steps_ && length >= max_episode_steps_;
+                rewards_[env] = vec.rewards()[j];
+                terminated_[env] = term;
+                truncated_[env] = trunc;
+                if (term || trunc) {
+                    writeObservation(shard, j, true);
+                    final_scores_[env] = vec.score[j];
+                    final_lengths_[env] = length;
+                    lengths_[env] = 0;
+                    vec.reset(j);
+                }
+                writeObservation(shard, j, false);
+            }
+        }
+    });
+}
+
+void TetrisVecEnv::writeObservation(Shard& shard, size_t local, bool final_row) {
+    const size_t env = shard.begin + local;
+    shard.vec->renderObservation(local, shard.cells.data());
+    const uint8_t* cells = shard.cells.data();
+    if (obs_dtype_ == ObsDtype::FLOAT32) {
+        float* dest = (final_row ? final_float_ : obs_float_).data() + env * stored_obs_dim_;
+        for (size_t i = 0; i < obs_dim_; i++) {
+            dest[i] = static_cast<float>(cells[i]);
+        }
+        return;
+    }
+    uint8_t* dest = (final_row ? final_bytes_ : obs_bytes_).data() + env * stored_obs_dim_;
+    if (obs_dtype_ == ObsDtype::PACKED) {
+        Observation::pack(cells, queue_size_, dest);
+    } else {
+        std::memcpy(dest, cells, obs_dim_);
+    }
+}
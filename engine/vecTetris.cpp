@@ -0,0 +1,302 @@
+#include "vecTetris.h"
+#include "pieceTables.h"
+#include "stepRules.h"
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
+namespace {
+
+constexpr int BoardH = Observation::BoardH;
+constexpr int BoardW = Observation::BoardW;
+constexpr int NumShapes = Tetris::NUM_PIECES * Tetris::NUM_ROTATIONS;
+
+// PIECE_TABLE widened to 32-bit entries, indexed by type * 4 + rotation,
+// so the AVX2 path can gather them
+struct GatherTables {
+    int32_t min_x[NumShapes];
+    int32_t max_x[NumShapes];
+    int32_t min_y[NumShapes];
+    int32_t max_y[NumShapes];
+    int32_t rows[NumShapes * Tetris::PIECE_SIZE];
+};
+
+constexpr GatherTables makeGatherTables() {
+    GatherTables t{};
+    for (int p = 0; p < Tetris::NUM_PIECES; p++) {
+        for (int r = 0; r < Tetris::NUM_ROTATIONS; r++) {
+            const Tetris::PieceShape& s = Tetris::PIECE_TABLE.shapes[p][r];
+            const int idx = p * Tetris::NUM_ROTATIONS + r;
+            t.min_x[idx] = s.min_x;
+            t.max_x[idx] = s.max_x;
+            t.min_y[idx] = s.min_y;
+            t.max_y[idx] = s.max_y;
+            for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
+                t.rows[idx * Tetris::PIECE_SIZE + y] = s.rows[y];
+            }
+        }
+    }
+    return t;
+}
+
+constexpr GatherTables GATHER = makeGatherTables();
+
+}  // namespace
+
+VecTetris::VecTetris(size_t num_envs, uint8_t queue_size, uint32_t seed_base, PieceRandomizer randomizer)
+    : queue_size(queue_size), num_envs_(num_envs) {
+    if (randomizer == PieceRandomizer::COMPAT) {
+        throw std::invalid_argument("COMPAT pieces are only available on TetrisGame");
+    }
+    // The AVX2 gather reads 32 bits at each 16-bit row, so keep two spare
+    // rows past the last env
+    board_rows.assign(num_envs * BoardH + 2, TetrisGame::EmptyRow);
+    board_cells.assign(num_envs * BoardH * Tetris::BOARD_WIDTH, 0);
+    column_heights.assign(num_envs * Tetris::BOARD_WIDTH, 0);
+    current_x.assign(num_envs, 0);
+    current_y.assign(num_envs, 0);
+    current_piece_type.assign(num_envs, 0);
+    rotation.assign(num_envs, 0);
+    holder_type.assign(num_envs, 7);
+    queue.assign(num_envs * queue_size, 0);
+    queue_index.assign(num_envs, 0);
+    score.assign(num_envs, 0);
+    game_over.assign(num_envs, 0);
+    rewards_.assign(num_envs, 0.0f);
+    cand_x_.assign(num_envs, 0);
+    cand_y_.assign(num_envs, 0);
+    cand_rot_.assign(num_envs, 0);
+    moving_.assign(num_envs, 0);
+    hits_.assign(num_envs, 0);
+
+    obs_size_ = 2 * static_cast<size_t>(BoardH) * BoardW +
+                static_cast<size_t>(Tetris::PIECE_SIZE) * Tetris::PIECE_SIZE +
+                static_cast<size_t>(queue_size) * Tetris::PIECE_SIZE * Tetris::PIECE_SIZE;
+
+    piece_sources.reserve(num_envs);
+    for (size_t i = 0; i < num_envs; ++i) {
+        piece_sources.emplace_back(seed_base + static_cast<uint32_t>(i), randomizer);
+        reset(i);
+    }
+}
+
+uint8_t VecTetris::samplePiece(size_t env) {
+    return piece_sources[env].next();
+}
+
+uint8_t VecTetris::getNextPiece(size_t env) {
+    uint8_t* q = &queue[env * queue_size];
+    uint8_t next_piece = q[queue_index[env]];
+    q[queue_index[env]] = samplePiece(env);
+    queue_index[env] = (queue_index[env] + 1) % queue_size;
+    return next_piece;
+}
+
+void VecTetris::reset(size_t env) {
+    std::fill_n(&board_rows[env * BoardH], BoardH, TetrisGame::EmptyRow);
+    std::memset(&board_cells[env * BoardH * Tetris::BOARD_WIDTH], 0, BoardH * Tetris::BOARD_WIDTH);
+    std::memset(&column_heights[env * Tetris::BOARD_WIDTH], 0, Tetris::BOARD_WIDTH);
+    score[env] = 0;
+    rewards_[env] = 0.0f;
+    game_over[env] = 0;
+    holder_type[env] = 7;
+
+    for (int i = 0; i < queue_size; i++) {
+        queue[env * queue_size + i] = samplePiece(env);
+    }
+    queue_index[env] = 0;
+
+    EnvView g = view(env);
+    StepRules::spawnPiece(g);
+    if (StepRules::collides(g, current_x[env], current_y[env], rotation[env])) {
+        game_over[env] = 1;
+    }
+}
+
+void VecTetris::resetAll() {
+    for (size_t i = 0; i < num_envs_; ++i) {
+        reset(i);
+    }
+}
+
+uint8_t VecTetris::getCell(size_t env, int x, int y) const {
+    if (x < 0 || x >= Tetris::BOARD_WIDTH || y < 0 || y >= BoardH) {
+        return 0;
+    }
+    return board_cells[(env * BoardH + y) * Tetris::BOARD_WIDTH + x];
+}
+
+int VecTetris::getGhostY(size_t env) const {
+    return Rules::landingY(&board_rows[env * BoardH], &column_heights[env * Tetris::BOARD_WIDTH],
+                           current_piece_type[env], current_x[env], current_y[env], rotation[env]);
+}
+
+void VecTetris::collideBatch(const int8_t* xs, const int8_t* ys, const uint8_t* rots, uint8_t* hits) const {
+    size_t i = 0;
+#if defined(__AVX2__)
+    // Eight envs per iteration: gather each env's shape bounds, piece rows
+    // and the four board rows under the piece, then AND them lane-wise
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i width_max = _mm256_set1_epi32(Tetris::BOARD_WIDTH - 1);
+    const __m256i height_max = _mm256_set1_epi32(BoardH - 1);
+    const __m256i low16 = _mm256_set1_epi32(0xFFFF);
+    const __m256i wall = _mm256_set1_epi32(TetrisGame::BoardWall);
+    const __m256i lanes = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+    const int* board = reinterpret_cast<const int*>(board_rows.data());
+
+    for (; i + 8 <= num_envs_; i += 8) {
+        const __m256i x = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(xs + i)));
+        const __m256i y = _mm256_cvtepi8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(ys + i)));
+        const __m256i rot = _mm256_cvtepu8_epi32(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(rots + i)));
+        const __m256i type = _mm256_cvtepu8_epi32(
+            _mm_loadl_epi64(reinterpret_cast<const __m128i*>(current_piece_type.data() + i)));
+        const __m256i shape = _mm256_add_epi32(_mm256_slli_epi32(type, 2), rot);
+
+        const __m256i min_x = _mm256_i32gather_epi32(GATHER.min_x, shape, 4);
+        const __m256i max_x = _mm256_i32gather_epi32(GATHER.max_x, shape, 4);
+        const __m256i min_y = _mm256_i32gather_epi32(GATHER.min_y, shape, 4);
+        const __m256i max_y = _mm256_i32gather_epi32(GATHER.max_y, shape, 4);
+        __m256i hit = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpgt_epi32(zero, _mm256_add_epi32(x, min_x)),
+                            _mm256_cmpgt_epi32(_mm256_add_epi32(x, max_x), width_max)),
+            _mm256_or_si256(_mm256_cmpgt_epi32(zero, _mm256_add_epi32(y, min_y)),
+                            _mm256_cmpgt_epi32(_mm256_add_epi32(y, max_y), height_max)));
+
+        // Out-of-range lanes are already hits; clamping keeps their gathers in bounds
+        const __m256i shift = _mm256_add_epi32(x, wall);
+        const __m256i env_base = _mm256_mullo_epi32(
+            _mm256_add_epi32(_mm256_set1_epi32(static_cast<int>(i)), lanes), _mm256_set1_epi32(BoardH));
+        const __m256i shape_rows = _mm256_slli_epi32(shape, 2);
+        for (int r = 0; r < Tetris::PIECE_SIZE; r++) {
+            const __m256i piece_row = _mm256_i32gather_epi32(
+                GATHER.rows, _mm256_add_epi32(shape_rows, _mm256_set1_epi32(r)), 4);
+            const __m256i row_y = _mm256_min_epi32(
+                _mm256_max_epi32(_mm256_add_epi32(y, _mm256_set1_epi32(r)), zero), height_max);
+            const __m256i row = _mm256_and_si256(
+                _mm256_i32gather_epi32(board, _mm256_add_epi32(env_base, row_y), 2), low16);
+            const __m256i overlap = _mm256_and_si256(row, _mm256_sllv_epi32(piece_row, shift));
+            hit = _mm256_or_si256(hit, _mm256_andnot_si256(_mm256_cmpeq_epi32(overlap, zero),
+                                                           _mm256_set1_epi32(-1)));
+        }
+
+        const int mask = _mm256_movemask_ps(_mm256_castsi256_ps(hit));
+        for (int k = 0; k < 8; k++) {
+            hits[i + k] = (mask >> k) & 1;
+        }
+    }
+#endif
+    for (; i < num_envs_; ++i) {
+        hits[i] = Rules::collides(&board_rows[i * BoardH], current_piece_type[i], xs[i], ys[i], rots[i]);
+    }
+}
+
+VecTetris::EnvView VecTetris::view(size_t env) {
+    return EnvView{*this, env, &board_rows[env * BoardH], current_x[env], current_y[env], rotation[env],
+                   current_piece_type[env], holder_type[env], score[env], rewards_[env], game_over[env], 0, 0};
+}
+
+void VecTetris::EnvView::lockPiece() {
+    Rules::lockPiece(board_rows, &vec.board_cells[env * BoardH * Tetris::BOARD_WIDTH],
+                     &vec.column_heights[env * Tetris::BOARD_WIDTH], current_piece_type, current_x, current_y,
+                     rotation);
+}
+
+int VecTetris::EnvView::clearLines() {
+    clearing_y = current_y;
+    clearing_rows = Rules::fullRows(board_rows, current_y);
+    return __builtin_popcount(clearing_rows);
+}
+
+void VecTetris::EnvView::completeClearLines() {
+    Rules::clearRows(board_rows, &vec.board_cells[env * BoardH * Tetris::BOARD_WIDTH],
+                     &vec.column_heights[env * Tetris::BOARD_WIDTH], clearing_y, clearing_rows);
+    clearing_rows = 0;
+}
+
+void VecTetris::step(const int* actions) {
+    // Action phase: moves become candidates tested in one batch, DROP and
+    // SWAP resolve immediately since they don't need a shared collision pass
+    for (size_t i = 0; i < num_envs_; ++i) {
+        rewards_[i] = 0.0f;
+        int x = current_x[i];
+        int y = current_y[i];
+        uint8_t rot = rotation[i];
+        const uint8_t action = static_cast<uint8_t>(actions[i]);
+        moving_[i] = StepRules::moveTarget(action, x, y, rot);
+        cand_x_[i] = static_cast<int8_t>(x);
+        cand_y_[i] = static_cast<int8_t>(y);
+        cand_rot_[i] = rot;
+        if (!moving_[i]) {
+            EnvView g = view(i);
+            StepRules::applyAction(g, action);
+            g.completeClearLines();
+        }
+    }
+    collideBatch(cand_x_.data(), cand_y_.data(), cand_rot_.data(), hits_.data());
+    for (size_t i = 0; i < num_envs_; ++i) {
+        if (moving_[i] && !hits_[i]) {
+            current_x[i] = cand_x_[i];
+            current_y[i] = cand_y_[i];
+            rotation[i] = cand_rot_[i];
+        }
+    }
+
+    // Gravity phase: one batched test of every piece one row lower
+    for (size_t i = 0; i < num_envs_; ++i) {
+        cand_x_[i] = current_x[i];
+        cand_y_[i] = current_y[i] - 1;
+        cand_rot_[i] = rotation[i];
+    }
+    collideBatch(cand_x_.data(), cand_y_.data(), cand_rot_.data(), hits_.data());
+    for (size_t i = 0; i < num_envs_; ++i) {
+        if (hits_[i]) {
+            EnvView g = view(i);
+            StepRules::lockAndSpawn(g);
+            g.completeClearLines();
+        } else {
+            current_y[i] -= 1;
+        }
+    }
+}
+
+void VecTetris::renderObservation(size_t env, uint8_t* dest) const {
+    std::memset(dest, 0, obs_size_);
+    uint8_t* active = dest;
+    uint8_t* board = dest + BoardH * BoardW;
+    uint8_t* holder = dest + 2 * BoardH * BoardW;
+    uint8_t* next = holder + Tetris::PIECE_SIZE * Tetris::PIECE_SIZE;
+
+    const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[current_piece_type[env]][rotation[env]];
+    for (int i = 0; i < Tetris::PIECE_CELLS; i++) {
+        const int board_y = current_y[env] + shape.cell_y[i];
+        const int board_x = current_x[env] + shape.cell_x[i];
+        if (board_y >= 0 && board_y < BoardH && board_x >= 0 && board_x < BoardW) {
+            active[board_y * BoardW + board_x] = 1;
+        }
+    }
+
+    const uint8_t* cells = &board_cells[env * BoardH * Tetris::BOARD_WIDTH];
+    for (int y = 0; y < BoardH; y++) {
+        std::memcpy(board + y * BoardW, cells + y * Tetris::BOARD_WIDTH, Tetris::BOARD_WIDTH);
+    }
+
+    auto draw_piece = [](uint8_t* grid, uint8_t type) {
+        for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
+            const uint8_t bits = Tetris::PIECE_TABLE.shapes[type][0].rows[y];
+            for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
+                grid[y * Tetris::PIECE_SIZE + x] = (bits >> x) & 1;
+            }
+        }
+    };
+    if (holder_type[env] < 7) {
+        draw_piece(holder, holder_type[env]);
+    }
+    const uint8_t* q = &queue[env * queue_size];
+    for (int i = 0; i < queue_size; i++) {
+        draw_piece(next + i * Tetris::PIECE_SIZE * Tetris::PIECE_SIZE, q[(queue_index[env] + i) % queue_size]);
+    }
+}
@@ -8,17 +8,22 @@
 #include <vector>
 #include <iostream>
 
+#include "heuristicAgent.h"
 #include "tetrisGame.h"
 
 constexpr int NUM_WORKERS = 100;
 
 int rl_loop(TetrisGame& game, int steps, int id) {
-    // TODO: implement RL training loop; placeholder keeps compiler happy
-    for (int i = 0; i < steps; i++) {
-        game.step(0);
+    // TODO: implement RL training loop; until then play placements with the
+    // heuristic agent so the load looks like a real policy's
+    HeuristicAgent agent;
+    int i = 0;
+    for (; i < steps && !game.isGameOver(); i++) {
+        game.stepPlacement(agent.choose(game));
         //print pid and step count
         // std::cout << "PID: " << id << ", Step: " << i << std::endl;
     }
+    return i;
 }
 
 int main() {
@@ -0,0 +1,91 @@
+#include "workerPool.h"
+#include <algorithm>
+#include <utility>
+#include "hostTuning.h"
+
+WorkerPool::WorkerPool(size_t num_threads, std::vector<int> cpus) : cpus_(std::move(cpus)) {
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    errors_.resize(num_threads);
+    for (size_t w = 1; w < num_threads; w++) {
+        threads_.emplace_back(&WorkerPool::loop, this, w);
+    }
+}
+
+WorkerPool::~WorkerPool() {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+    }
+    start_cv_.notify_all();
+    for (std::thread& thread : threads_) {
+        thread.join();
+    }
+}
+
+void WorkerPool::parallelFor(size_t count, const Task& fn) {
+    std::fill(errors_.begin(), errors_.end(), nullptr);
+    if (!threads_.empty()) {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            task_ = &fn;
+            task_count_ = count;
+            pending_ = threads_.size();
+            generation_++;
+        }
+        start_cv_.notify_all();
+    }
+
+    try {
+        fn(0, 0, count / size());
+    } catch (...) {
+        errors_[0] = std::current_exception();
+    }
+
+    if (!threads_.empty()) {
+        std::unique_lock<std::mutex> lock(mutex_);
+        done_cv_.wait(lock, [this] { return pending_ == 0; });
+        task_ = nullptr;
+    }
+    for (const std::exception_ptr& error : errors_) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+void WorkerPool::loop(size_t worker) {
+    if (!cpus_.empty()) {
+        pinCurrentThread(cpus_[worker % cpus_.size()]);
+    }
+    uint64_t seen = 0;
+    while (true) {
+        const Task* task;
+        size_t count;
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            start_cv_.wait(lock, [&] { return stopping_ || generation_ != seen; });
+            if (stopping_) {
+                return;
+            }
+            seen = generation_;
+            task = task_;
+            count = task_count_;
+        }
+
+        const size_t begin = count * worker / size();
+        const size_t end = count * (worker + 1) / size();
+        try {
+            (*task)(worker, begin, end);
+        } catch (...) {
+            errors_[worker] = std::current_exception();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            pending_--;
+        }
+        done_cv_.notify_one();
+    }
+}
@@ -147,15 +147,18 @@ def benchmark_wrapped_tinyrl(num_steps: int):
         'steps_per_sec': steps_per_sec
     }
 
-def benchmark_batched_collector(num_workers: int, num_episodes: int, max_steps: int):
-    """Benchmark the multithreaded C++ BatchedTetrisCollector."""
+def benchmark_batched_collector(num_workers: int, num_episodes: int, max_steps: int, tuned: bool = False):
+    """Benchmark the multithreaded C++ BatchedTetrisCollector; tuned pins
+    its workers and puts observations on huge pages."""
     print("\n" + "="*60)
-    print("BENCHMARKING: Batched C++ Collector")
+    print("BENCHMARKING: Batched C++ Collector" + (" (pinned + huge pages)" if tuned else ""))
     print("="*60)
 
     from src.batched_collector import BatchedTetrisCollector
 
-    collector = BatchedTetrisCollector(num_workers=num_workers, max_steps=max_steps)
+    collector = BatchedTetrisCollector(
+        num_workers=num_workers, max_steps=max_steps, pin_workers=tuned, huge_pages=tuned
+    )
     start_time = time.time()
     batch = collector.request_episodes(num_episodes)
     collector.close()
@@ -171,7 +174,7 @@ def benchmark_batched_collector(num_workers: int, num_episodes: int, max_steps:
     print(f"Speed: {steps_per_sec:,.1f} steps/sec")
 
     return {
-        'name': f'Batched Collector ({num_workers} workers)',
+        'name': f'Batched Collector ({num_workers} workers{", tuned" if tuned else ""})',
         'steps': total_steps,
         'episodes': num_episodes,
         'time': elapsed,
@@ -197,13 +200,13 @@ def print_comparison(results):
     fastest = max(valid_results, key=lambda x: x['steps_per_sec'])
 
     # Print table
-    print(f"{'Environment':<30} {'Steps/sec':>15} {'Speedup':>10}")
-    print("-" * 60)
+    print(f"{'Environment':<38} {'Steps/sec':>15} {'Speedup':>10}")
+    print("-" * 65)
 
     for result in valid_results:
         speedup = result['steps_per_sec'] / fastest['steps_per_sec']
         speedup_str = f"{speedup:.2f}x" if result != fastest else "baseline"
-        print(f"{result['name']:<30} {result['steps_per_sec']:>15,.1f} {speedup_str:>10}")
+        print(f"{result['name']:<38} {result['steps_per_sec']:>15,.1f} {speedup_str:>10}")
 
     print()
     print(f"🏆 Winner: {fastest['name']}")
@@ -216,6 +219,8 @@ def parse_args():
     parser.add_argument("--batch-episodes", type=int, default=8, help="Episodes requested per batched call.")
     parser.add_argument("--batch-max-steps", type=int, default=512, help="Max steps per episode for batched collector.")
     parser.add_argument("--skip-python", action="store_true", help="Skip Tetris-Gymnasium benchmark.")
+    parser.add_argument("--skip-tuned", action="store_true",
+                        help="Skip the collector run with pinned workers and huge pages.")
     return parser.parse_args()
 
 
@@ -239,5 +244,12 @@ if __name__ == "__main__":
         num_episodes=args.batch_episodes,
         max_steps=args.batch_max_steps,
     ))
+    if not args.skip_tuned:
+        results.append(benchmark_batched_collector(
+            num_workers=args.batch_workers,
+            num_episodes=args.batch_episodes,
+            max_steps=args.batch_max_steps,
+            tuned=True,
+        ))
 
     print_comparison(results)
@@ -35,17 +35,23 @@ def old_style_rollouts(env_id: str, num_episodes: int, max_steps: int) -> float:
     return time.perf_counter() - start
 
 
-def batched_rollouts(env_id: str, num_episodes: int, max_steps: int) -> float:
-    collector = BatchedTetrisCollector(COLLECTOR_WORKERS, max_steps)
+def batched_rollouts(env_id: str, num_episodes: int, max_steps: int, batching: str, tuned: bool = False) -> float:
+    collector = BatchedTetrisCollector(COLLECTOR_WORKERS, max_steps, pin_workers=tuned, huge_pages=tuned)
     start = time.perf_counter()
-    collector.request_episodes(num_episodes)  # random policy if none provided
+    collector.request_episodes(num_episodes, batching=batching)  # random policy if none provided
+    elapsed = time.perf_counter() - start
+    if batching == "dynamic":
+        stats = collector.broker_stats()
+        print(f"batch sizes: {stats['batch_sizes'].tolist()}")
+        print(f"queue latency (<2**b us): {stats['queue_latency_us'].tolist()}")
     collector.close()
-    return time.perf_counter() - start
+    return elapsed
 
 
-def run_benchmark(env_id: str, num_episodes: int, max_steps: int, repeats: int):
+def run_benchmark(env_id: str, num_episodes: int, max_steps: int, repeats: int, batching: str, tuned: bool):
     old_times = [old_style_rollouts(env_id, num_episodes, max_steps) for _ in range(repeats)]
-    new_times = [batched_rollouts(env_id, num_episodes, max_steps) for _ in range(repeats)]
+    new_times = [batched_rollouts(env_id, num_episodes, max_steps, batching) for _ in range(repeats)]
+    tuned_times = [batched_rollouts(env_id, num_episodes, max_steps, batching, True) for _ in range(repeats)] if tuned else []
 
     def summarize(label: str, data):
         avg = statistics.mean(data)
@@ -54,7 +60,9 @@ def run_benchmark(env_id: str, num_episodes: int, max_steps: int, repeats: int):
 
     print(f"\nBenchmark results ({num_episodes=} episodes, {max_steps=} max steps, repeats={repeats}):")
     summarize("Old env.step loop", old_times)
-    summarize("Batched collector", new_times)
+    summarize(f"Batched collector ({batching})", new_times)
+    if tuned_times:
+        summarize(f"Batched collector ({batching}, pinned + huge pages)", tuned_times)
 
 
 def parse_args() -> argparse.Namespace:
@@ -63,9 +71,13 @@ def parse_args() -> argparse.Namespace:
     parser.add_argument("--max-steps", type=int, default=256, help="Max steps per episode.")
     parser.add_argument("--repeats", type=int, default=5, help="How many times to repeat each measurement.")
     parser.add_argument("--env-id", default=ENV_NAME, help="Gym env ID to benchmark.")
+    parser.add_argument("--batching", default="per_worker", choices=["per_worker", "lockstep", "dynamic"],
+                        help="How the collector batches policy calls.")
+    parser.add_argument("--skip-tuned", action="store_true",
+                        help="Skip the second collector run with pinned workers and huge pages.")
     return parser.parse_args()
 
 
 if __name__ == "__main__":
     args = parse_args()
-    run_benchmark(args.env_id, args.episodes, args.max_steps, args.repeats)
+    run_benchmark(args.env_id, args.episodes, args.max_steps, args.repeats, args.batching, not args.skip_tuned)
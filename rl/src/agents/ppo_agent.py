@@ -1,4 +1,6 @@
 # src/agents/ppo_agent.py
+import copy
+
 import torch
 import torch.nn as nn
 import torch.optim as optim
@@ -11,7 +13,7 @@ from src.models.actor_critic import ActorCritic
 from src.configs.hyperparameters import (
     GAMMA, LAMBDA, CLIP_EPS, VALUE_CLIP_EPS, ENTROPY_COEF,
     VALUE_LOSS_COEF, EPOCHS, BATCH_SIZE, MAX_STEPS,
-    ROLLOUT_EPISODES, COLLECTOR_WORKERS,
+    ROLLOUT_STEPS, COLLECTOR_WORKERS, ASYNC_COLLECTION, NATIVE_POLICY,
     LEARNING_RATE, HIDDEN_SIZE,
     NUM_UPDATES, ENV_NAME
 )
@@ -19,77 +21,76 @@ from src.wrappers import FlattenObservation
 import src.env_wrapper # registers the env
 from src.batched_collector import BatchedTetrisCollector
 
-def collect_rollouts(collector, model, num_episodes):
-    """Use the multithreaded collector to gather padded episode batches."""
-    def policy_fn(state: np.ndarray):
-        state_tensor = torch.from_numpy(state).float().unsqueeze(0)
+def make_policy_fn(model):
+    """Batched policy for lockstep collection: one forward pass per step for all workers' envs."""
+    def policy_fn(states: np.ndarray):
         with torch.no_grad():
-            action, log_prob, _, value = model.get_action_and_value(state_tensor)
-        return action.item(), float(log_prob.item()), float(value.item())
+            action, log_prob, _, value = model.get_action_and_value(torch.from_numpy(states))
+        return action.numpy(), log_prob.numpy(), value.numpy()
 
-    batch = collector.request_episodes(num_episodes, policy_fn)
+    return policy_fn
 
-    states, actions, log_probs, rewards, dones, values = [], [], [], [], [], []
-    for ep in range(num_episodes):
-        length = int(batch.lengths[ep])
-        if length <= 0:
-            continue
 
-        states.extend(batch.observations[ep, :length])
-        actions.extend(batch.actions[ep, :length])
-        rewards.extend(batch.rewards[ep, :length])
-        dones.extend(batch.dones[ep, :length])
+def rollout_policy(collector, model):
+    """policy_fn for the collector playing model: with NATIVE_POLICY its
+    weights are copied into the collector, which runs them without Python."""
+    if NATIVE_POLICY:
+        collector.set_policy_weights(model)
+        return "native"
+    return make_policy_fn(model)
 
-        for step_idx in range(length):
-            log_probs.append(torch.tensor([batch.log_probs[ep, step_idx]], dtype=torch.float32))
-            values.append(torch.tensor([batch.values[ep, step_idx]], dtype=torch.float32))
 
-    if states and not dones[-1]:
-        next_state_tensor = torch.from_numpy(states[-1]).float().unsqueeze(0)
-        with torch.no_grad():
-            _, _, _, next_value = model.get_action_and_value(next_state_tensor)
-    else:
-        next_value = torch.zeros(1)
+def collect_rollouts(collector, model, num_steps):
+    """Use the multithreaded collector to play num_steps in each of its envs."""
+    batch = collector.request_segments(num_steps, rollout_policy(collector, model))
+    return unpack_rollouts(collector, model, batch)
+
+
+def unpack_rollouts(collector, model, batch):
+    """Flatten a [num_envs, T] SegmentBatch into per-step arrays for the update.
 
-    return states, actions, log_probs, rewards, dones, values, next_value
+    GAE runs per env row, so the step arrays stay [num_envs, T]; next_values
+    are the model's values of each env's observation after the segment."""
+    obs = batch.observations
+    states = collector.unpack(obs.reshape(-1, obs.shape[-1]))
+    actions = batch.actions.reshape(-1).astype(np.int64)
+    log_probs = [torch.from_numpy(batch.log_probs.reshape(-1))]
+    # A game that ended either way starts over on the next step
+    dones = batch.dones | batch.truncated
+    with torch.no_grad():
+        _, _, _, next_values = model.get_action_and_value(torch.from_numpy(collector.unpack(batch.next_observations)))
 
+    return states, actions, log_probs, batch.rewards, dones, batch.values, next_values.numpy()
 
-def compute_advantages_and_returns(rewards, dones, values, next_value, gamma, lambda_):
+
+def compute_advantages_and_returns(rewards, dones, values, next_values, gamma, lambda_):
     """
     Computes GAE advantages and returns (paper Section 5, citing [Sch+15a])
 
-    Initialize lists, gae=0, next_val from last state.
+    rewards, dones, values are [num_envs, T]; next_values [num_envs] is the
+    value after each env's last step. Every env is handled at once.
 
-    Reverse loop for efficient GAE calculation.
-    for r, d, v in zip(reversed(rewards), reversed(dones), reversed(values)):
-        If done, reset gae to TD error delta = r - V(s).
+    Reverse loop over t, with gae=0 and next_val=next_values:
+        If done, delta = r - V(s) and gae restarts from it: the next step
+        belongs to a new game (truncations are treated the same way).
         Else, delta = r + γ V(s_{t+1}) - V(s_t), gae = delta + γ λ gae.
-        Append gae (A_t), return = gae + V(s_t).
-        Update next_val.
+        A_t = gae, return = gae + V(s_t); next_val = V(s_t).
 
-    Reverse lists to original order.
-    Return as tensors.
+    Return both flattened to [num_envs * T] tensors, in the states' order.
     """
-    advantages = []
-    returns = []
-    gae = 0
-    next_val = next_value.item()
-
-    for r, d, v in zip(reversed(rewards), reversed(dones), reversed(values)):
-        if d:
-            delta = r - v.item()
-            gae = delta
-        else:
-            delta = r + gamma * next_val - v.item()
-            gae = delta + gamma * lambda_ * gae
-        advantages.append(gae)
-        returns.append(gae + v.item())
-        next_val = v.item() if d else next_val
+    advantages = np.zeros_like(values, dtype=np.float32)
+    gae = np.zeros(values.shape[0], dtype=np.float32)
+    next_val = next_values
 
-    advantages = advantages[::-1]
-    returns = returns[::-1]
+    for t in reversed(range(values.shape[1])):
+        not_done = 1.0 - dones[:, t].astype(np.float32)
+        delta = rewards[:, t] + gamma * next_val * not_done - values[:, t]
+        gae = delta + gamma * lambda_ * not_done * gae
+        advantages[:, t] = gae
+        next_val = values[:, t]
 
-    return torch.tensor(advantages), torch.tensor(returns)
+    returns = advantages + values
+    return torch.from_numpy(advantages.reshape(-1)), torch.from_numpy(returns.reshape(-1))
 
 def ppo_update(model, optimizer, states, actions, old_log_probs, advantages, returns, clip_eps, value_clip_eps, entropy_coef, value_loss_coef, epochs, batch_size):
     """
@@ -174,12 +175,25 @@ def train_ppo():
     optimizer = optim.Adam(model.parameters(), lr=LEARNING_RATE)
     print("Starting training...")
 
+    # With ASYNC_COLLECTION the next batch is collected while this one trains.
+    # It plays a snapshot of the weights, one update behind the learner.
+    actor = copy.deepcopy(model)
+    if ASYNC_COLLECTION:
+        handle = collector.submit_segments(ROLLOUT_STEPS, rollout_policy(collector, actor), policy_version=0)
+
     for update in range(NUM_UPDATES):
-        states_list, actions_list, log_probs_list, rewards_list, dones_list, values_list, next_value = collect_rollouts(
-            collector, model, ROLLOUT_EPISODES
-        )
+        if ASYNC_COLLECTION:
+            batch = collector.wait(handle)
+            if update + 1 < NUM_UPDATES:
+                actor.load_state_dict(model.state_dict())
+                handle = collector.submit_segments(ROLLOUT_STEPS, rollout_policy(collector, actor),
+                                                   policy_version=update)
+            rollouts = unpack_rollouts(collector, model, batch)
+        else:
+            rollouts = collect_rollouts(collector, model, ROLLOUT_STEPS)
+        states_list, actions_list, log_probs_list, rewards, dones, values, next_values = rollouts
 
-        advantages, returns = compute_advantages_and_returns(rewards_list, dones_list, values_list, next_value, GAMMA, LAMBDA)
+        advantages, returns = compute_advantages_and_returns(rewards, dones, values, next_values, GAMMA, LAMBDA)
 
         ppo_update(model, optimizer, states_list, actions_list, log_probs_list, advantages, returns, CLIP_EPS, VALUE_CLIP_EPS, ENTROPY_COEF, VALUE_LOSS_COEF, EPOCHS, BATCH_SIZE)
 
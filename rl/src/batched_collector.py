@@ -5,7 +5,7 @@ Python façade over the multithreaded C++ BatchedTetrisCollector.
 from __future__ import annotations
 
 from collections import namedtuple
-from typing import Callable, Optional, Tuple
+from typing import Callable, Tuple, Union
 
 import gymnasium as gym
 import numpy as np
@@ -16,43 +16,279 @@ import tinyrl_tetris
 
 EpisodeBatch = namedtuple(
     "EpisodeBatch",
-    ["observations", "actions", "log_probs", "values", "rewards", "dones", "lengths"],
+    ["observations", "actions", "log_probs", "values", "rewards", "dones", "lengths", "policy_version"],
+    defaults=(0,),
 )
 
+# request_segments: [num_envs, num_steps] of continuous play per field, no
+# padding. dones marks steps that ended a game, truncated steps that hit
+# max_steps; either way the next step is the first of a new game.
+# next_observations [num_envs, ...] is what each env observes after its last
+# step.
+SegmentBatch = namedtuple(
+    "SegmentBatch",
+    ["observations", "actions", "log_probs", "values", "rewards", "dones", "truncated", "next_observations",
+     "policy_version"],
+    defaults=(0,),
+)
+
+# A callable, "native" for the weights given to set_policy_weights(), or
+# None for random actions
+PolicyFn = Union[Callable[..., Tuple], str, None]
+
 
 class BatchedTetrisCollector:
     """Wrapper that exposes the C++ collector to Python."""
 
-    def __init__(self, num_workers: int, max_steps: int, queue_size: int = 3):
+    def __init__(
+        self,
+        num_workers: int,
+        max_steps: int,
+        queue_size: int = 3,
+        obs_mode: str = "board",
+        action_mode: str = "primitive",
+        randomizer: str = "uniform",
+        obs_dtype: str = "float32",
+        pin_workers: bool = False,
+        huge_pages: bool = False,
+    ):
+        """obs_mode is "board" (flattened full observation) or "features"
+        (the engine's compact board-feature vector).
+
+        action_mode is "primitive" (policy_fn(obs) picks one of the 8
+        actions) or "placement" (policy_fn(obs, afterstates) picks a row of
+        afterstates, one per reachable final placement of the current or
+        held piece: lines cleared followed by the resulting board features).
+
+        randomizer is "uniform", "bag7" (shuffled bags of all seven pieces)
+        or "compat" (the piece sequences of engine versions before the
+        PCG32 generator).
+
+        obs_dtype picks how "board" observations are stored: "float32",
+        "uint8" (one byte per cell) or "packed" (0/1 planes 8 cells per
+        byte, board 2 per byte). Use unpack() to get float32 back, one
+        minibatch at a time.
+
+        pin_workers pins worker i (and the thread stepping env i in
+        lockstep/segment mode) to the i-th CPU this process may use; each
+        worker allocates its own env and buffers, so they end up on its
+        NUMA node. huge_pages backs the observation arrays with transparent
+        huge pages where the OS allows. Both are off by default."""
         if num_workers <= 0:
             raise ValueError("num_workers must be positive")
-        self.core = tinyrl_tetris.BatchedTetrisCollector(num_workers, max_steps, queue_size)
+        mode = {"board": tinyrl_tetris.ObsMode.BOARD, "features": tinyrl_tetris.ObsMode.FEATURES}[obs_mode]
+        actions = {
+            "primitive": tinyrl_tetris.ActionMode.PRIMITIVE,
+            "placement": tinyrl_tetris.ActionMode.PLACEMENT,
+        }[action_mode]
+        pieces = {
+            "uniform": tinyrl_tetris.PieceRandomizer.UNIFORM,
+            "bag7": tinyrl_tetris.PieceRandomizer.BAG7,
+            "compat": tinyrl_tetris.PieceRandomizer.COMPAT,
+        }[randomizer]
+        dtype = {
+            "float32": tinyrl_tetris.ObsDtype.FLOAT32,
+            "uint8": tinyrl_tetris.ObsDtype.UINT8,
+            "packed": tinyrl_tetris.ObsDtype.PACKED,
+        }[obs_dtype]
+        self.action_mode = action_mode
+        self.obs_dtype = obs_dtype
+        self.queue_size = queue_size
+        self.core = tinyrl_tetris.BatchedTetrisCollector(
+            num_workers,
+            max_steps,
+            queue_size,
+            obs_mode=mode,
+            action_mode=actions,
+            randomizer=pieces,
+            obs_dtype=dtype,
+            pin_workers=pin_workers,
+            huge_pages=huge_pages,
+        )
         self.max_steps = max_steps
+        self.num_envs = num_workers
         self.obs_dim = self.core.obs_dim
         self.action_space = gym.spaces.Discrete(7)  # Matches engine action count
 
     def request_episodes(
         self,
         num_episodes: int,
-        policy_fn: Optional[Callable[[np.ndarray], Tuple[int, float, float]]] = None,
+        policy_fn: PolicyFn = None,
+        batching: str = "per_worker",
     ) -> EpisodeBatch:
+        """With batching="per_worker" each worker calls policy_fn(obs) with
+        one [obs_dim] observation and gets (action, log_prob, value) back.
+
+        With "lockstep" or "dynamic" policy_fn gets an [n, obs_dim] batch
+        (and a list of n afterstate arrays in placement mode) and returns
+        (actions, log_probs, values) arrays of length n. "lockstep" steps
+        every worker's env together, so one model call serves every worker.
+        "dynamic" lets workers run freely and batches their queued requests
+        once max_batch_size are waiting or the oldest has waited max_wait_us
+        (see broker_stats()).
+
+        policy_fn="native" runs the weights from set_policy_weights() in the
+        workers themselves, with no Python calls (batching is ignored).
+        policy_fn=None plays random actions."""
+        policy_fn, mode = self._prepare(policy_fn, batching)
+        return self._to_batch(self.core.request_episodes(num_episodes, policy_fn, mode))
+
+    def submit(
+        self,
+        num_episodes: int,
+        policy_fn: PolicyFn = None,
+        batching: str = "per_worker",
+        policy_version: int = 0,
+    ) -> int:
+        """Start collecting like request_episodes and return a handle at once.
+
+        The workers collect in the background while Python keeps running, so
+        the learner can train on the previous batch meanwhile. One batch
+        collects at a time. policy_fn keeps being called until the batch is
+        done, so give it a snapshot of the model rather than the one being
+        trained; policy_version comes back on the batch to tell them apart."""
+        policy_fn, mode = self._prepare(policy_fn, batching)
+        return self.core.submit(num_episodes, policy_fn, mode, policy_version)
+
+    def request_segments(self, num_steps: int, policy_fn: PolicyFn = None) -> SegmentBatch:
+        """Play num_steps more steps in each of the num_workers envs and
+        return them as a SegmentBatch.
+
+        policy_fn is batched, as with batching="lockstep". Envs carry their
+        games over from one call to the next and start a new one as soon as
+        a game ends, so there is no padding and no waiting on long games.
+        With policy_fn="native" each stepping thread runs the native policy
+        on its envs as one batch."""
+        return self._to_batch(self.core.request_segments(num_steps, self._resolve(policy_fn, True)))
+
+    def submit_segments(
+        self,
+        num_steps: int,
+        policy_fn: PolicyFn = None,
+        policy_version: int = 0,
+    ) -> int:
+        """request_segments in the background, as submit() is for request_episodes."""
+        return self.core.submit_segments(num_steps, self._resolve(policy_fn, True), policy_version)
+
+    def poll(self, handle: int) -> bool:
+        """True once the submitted batch is ready for wait()."""
+        return self.core.poll(handle)
+
+    def wait(self, handle: int) -> Union[EpisodeBatch, SegmentBatch]:
+        """Block until the submitted batch is collected and return it."""
+        return self._to_batch(self.core.wait(handle))
+
+    def set_policy_weights(self, model) -> None:
+        """Copy an ActorCritic's weights in for policy_fn="native".
+
+        The collector keeps its own copy, so the model can go on training;
+        call this again to update it. Collections started afterwards play
+        the new weights; a submitted request_episodes batch may switch to
+        them at a worker's next episode."""
+        def numpy(tensor):
+            return tensor.detach().cpu().numpy().astype(np.float32, copy=False)
+
+        # The Linear layers of model.shared; the Tanh between them is implied
+        hidden = [layer for layer in model.shared if hasattr(layer, "weight")]
+        self.core.set_policy_weights(
+            [numpy(layer.weight) for layer in hidden],
+            [numpy(layer.bias) for layer in hidden],
+            numpy(model.actor.weight),
+            numpy(model.actor.bias),
+            numpy(model.critic.weight),
+            numpy(model.critic.bias),
+        )
+
+    def _resolve(self, policy_fn: PolicyFn, batched: bool):
+        if policy_fn == "native":
+            return None  # the core's native policy
         if policy_fn is None:
-            def policy_fn(_state: np.ndarray):
-                action = self.action_space.sample()
-                return action, 0.0, 0.0
+            return self._random_policy(batched)
+        return policy_fn
 
-        data = self.core.request_episodes(num_episodes, policy_fn)
-        dones = data["dones"].astype(bool, copy=False)
+    def _prepare(self, policy_fn, batching: str):
+        policy_fn = self._resolve(policy_fn, batching != "per_worker")
+        mode = {
+            "per_worker": tinyrl_tetris.PolicyBatching.PER_WORKER,
+            "lockstep": tinyrl_tetris.PolicyBatching.LOCKSTEP,
+            "dynamic": tinyrl_tetris.PolicyBatching.DYNAMIC,
+        }[batching]
+        return policy_fn, mode
 
+    @staticmethod
+    def _to_batch(data: dict) -> Union[EpisodeBatch, SegmentBatch]:
+        if "next_observations" in data:
+            return SegmentBatch(
+                observations=data["observations"],
+                actions=data["actions"],
+                log_probs=data["log_probs"],
+                values=data["values"],
+                rewards=data["rewards"],
+                dones=data["dones"].astype(bool, copy=False),
+                truncated=data["truncated"].astype(bool, copy=False),
+                next_observations=data["next_observations"],
+                policy_version=data.get("policy_version", 0),
+            )
         return EpisodeBatch(
             observations=data["observations"],
             actions=data["actions"],
             log_probs=data["log_probs"],
             values=data["values"],
             rewards=data["rewards"],
-            dones=dones,
+            dones=data["dones"].astype(bool, copy=False),
             lengths=data["lengths"],
+            policy_version=data.get("policy_version", 0),
         )
 
+    @property
+    def max_batch_size(self) -> int:
+        """Largest "dynamic" batch (defaults to num_workers)."""
+        return self.core.max_batch_size
+
+    @max_batch_size.setter
+    def max_batch_size(self, size: int):
+        self.core.max_batch_size = size
+
+    @property
+    def max_wait_us(self) -> int:
+        """How long a "dynamic" request waits for a batch to fill."""
+        return self.core.max_wait_us
+
+    @max_wait_us.setter
+    def max_wait_us(self, us: int):
+        self.core.max_wait_us = us
+
+    def broker_stats(self) -> dict:
+        """Histograms from the last "dynamic" request: batch_sizes[n] is the
+        number of policy calls with n rows, queue_latency_us[b] the number of
+        requests that waited under 2**b microseconds."""
+        return self.core.broker_stats()
+
+    def _random_policy(self, batched: bool):
+        def pick(afterstates: np.ndarray) -> int:
+            return np.random.randint(len(afterstates)) if len(afterstates) else 0
+
+        if batched and self.action_mode == "placement":
+            def policy_fn(states: np.ndarray, afterstates):
+                zeros = np.zeros(len(states), dtype=np.float32)
+                return np.array([pick(a) for a in afterstates], dtype=np.int32), zeros, zeros
+        elif batched:
+            def policy_fn(states: np.ndarray):
+                zeros = np.zeros(len(states), dtype=np.float32)
+                return np.random.randint(self.action_space.n, size=len(states), dtype=np.int32), zeros, zeros
+        elif self.action_mode == "placement":
+            def policy_fn(_state: np.ndarray, afterstates: np.ndarray):
+                return pick(afterstates), 0.0, 0.0
+        else:
+            def policy_fn(_state: np.ndarray):
+                return self.action_space.sample(), 0.0, 0.0
+        return policy_fn
+
+    def unpack(self, observations: np.ndarray) -> np.ndarray:
+        """float32 cells of stored observations (any leading shape)."""
+        if self.obs_dtype == "packed":
+            return tinyrl_tetris.unpack_observations(observations, self.queue_size)
+        return observations.astype(np.float32, copy=False)
+
     def close(self):
         self.core.close()
@@ -8,9 +8,11 @@ ENTROPY_COEF = 0.01
 VALUE_LOSS_COEF = 0.5
 EPOCHS = 4
 BATCH_SIZE = 64
-MAX_STEPS = 2048  # Reduced from 10000 for faster iteration (5x speedup)
-ROLLOUT_EPISODES = 8
+MAX_STEPS = 2048  # Games are truncated here (reduced from 10000 for faster iteration)
+ROLLOUT_STEPS = 512  # Steps per env per update: COLLECTOR_WORKERS * 512 transitions
 COLLECTOR_WORKERS = 4
+ASYNC_COLLECTION = False  # opt in: collect the next rollout while training on this one (one update stale)
+NATIVE_POLICY = False  # opt in: collectors run the actor in C++ instead of calling back into torch
 LEARNING_RATE = 3e-4
 HIDDEN_SIZE = 64
 NUM_UPDATES = 10000
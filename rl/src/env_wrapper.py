@@ -15,10 +15,17 @@ class TetrisEnv(gym.Env):
         - active_piece: (24, 18) - Current falling piece (binary mask)
         - queue: (queue_size*4, 4) - Next pieces stacked vertically
         - holder: (4, 4) - Held piece
+
+    With obs_mode="features" the observation is instead the engine's flat
+    float32 feature vector (column heights, wells, holes, transitions,
+    current/held/queued pieces).
     """
-    def __init__(self, queue_size=3):
+    def __init__(self, queue_size=3, obs_mode="board"):
         super().__init__()
+        if obs_mode not in ("board", "features"):
+            raise ValueError(f"unknown obs_mode {obs_mode!r}")
         self.queue_size = queue_size
+        self.obs_mode = obs_mode
         self.env = tinyrl_tetris.TetrisEnv(tinyrl_tetris.STEPPED, queue_size=queue_size)
 
         # Action space: 7 discrete actions (LEFT, RIGHT, DOWN, CW, CCW, DROP, SWAP)
@@ -31,9 +38,17 @@ class TetrisEnv(gym.Env):
             'queue': gym.spaces.Box(low=0, high=7, shape=(queue_size * 4, 4), dtype=np.uint8),
             'holder': gym.spaces.Box(low=0, high=7, shape=(4, 4), dtype=np.uint8),
         })
+        if obs_mode == "features":
+            self.observation_space = gym.spaces.Box(
+                low=-np.inf, high=np.inf, shape=(self.env.feature_dim,), dtype=np.float32
+            )
 
     def _get_obs(self):
-        return self.env.obs
+        if self.obs_mode == "features":
+            return self.env.features  # already a fresh array
+        # The engine's obs are read-only views that the next step overwrites;
+        # Gymnasium callers may keep observations, so hand them copies
+        return {k: v.copy() for k, v in self.env.obs.items()}
 
     def _get_info(self):
         return {"score": self.env.score, "game_over": self.env.game_over}
@@ -44,9 +59,9 @@ class TetrisEnv(gym.Env):
         return self._get_obs(), self._get_info()
 
     def step(self, action):
-        obs, reward, done, _  = self.env.step(action)
+        _, reward, done, _  = self.env.step(action)
         truncated = False
-        return obs, reward, done, truncated, self._get_info()
+        return self._get_obs(), reward, done, truncated, self._get_info()
 
 # register the env
 gym.register(
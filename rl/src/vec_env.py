@@ -0,0 +1,109 @@
+"""
+gymnasium VectorEnv over the native TetrisVecEnv: N games stepped by one
+C++ call with the GIL released.
+"""
+
+from __future__ import annotations
+
+from typing import Optional, Sequence, Union
+
+import gymnasium as gym
+import numpy as np
+
+import src.env_wrapper  # Ensures engine library is on sys.path
+import tinyrl_tetris
+
+
+class TetrisVecEnv(gym.vector.VectorEnv):
+    """Vectorized Tetris with same-step autoreset.
+
+    Observations are the flattened board observation (see
+    BatchedTetrisCollector's obs_dtype for "uint8" and "packed"). When an
+    episode ends, its row in the returned observations is already the next
+    episode's first; the last observation is in infos["final_obs"] (masked by
+    infos["_final_obs"]) with its score and length in infos["episode"].
+
+    The engine writes every step into the same buffers. With copy=False the
+    returned arrays are views of them and change on the next step.
+    """
+
+    def __init__(
+        self,
+        num_envs: int,
+        queue_size: int = 3,
+        seed: Optional[int] = None,
+        randomizer: str = "uniform",
+        num_threads: int = 1,
+        max_episode_steps: int = 0,
+        obs_dtype: str = "float32",
+        copy: bool = True,
+    ):
+        pieces = {
+            "uniform": tinyrl_tetris.PieceRandomizer.UNIFORM,
+            "bag7": tinyrl_tetris.PieceRandomizer.BAG7,
+        }[randomizer]
+        dtype = {
+            "float32": tinyrl_tetris.ObsDtype.FLOAT32,
+            "uint8": tinyrl_tetris.ObsDtype.UINT8,
+            "packed": tinyrl_tetris.ObsDtype.PACKED,
+        }[obs_dtype]
+        self.core = tinyrl_tetris.TetrisVecEnv(
+            num_envs,
+            queue_size,
+            seed=seed,
+            randomizer=pieces,
+            num_threads=num_threads,
+            max_episode_steps=max_episode_steps,
+            obs_dtype=dtype,
+        )
+        self.num_envs = num_envs
+        self.queue_size = queue_size
+        self.obs_dtype = obs_dtype
+        self.copy = copy
+
+        if obs_dtype == "packed":
+            self.single_observation_space = gym.spaces.Box(
+                low=0, high=255, shape=(self.core.stored_obs_dim,), dtype=np.uint8
+            )
+        else:
+            self.single_observation_space = gym.spaces.Box(
+                low=0, high=7, shape=(self.core.obs_dim,),
+                dtype=np.float32 if obs_dtype == "float32" else np.uint8,
+            )
+        # Same 8 actions as TetrisEnv.step, NOOP included
+        self.single_action_space = gym.spaces.Discrete(8)
+        self.observation_space = gym.vector.utils.batch_space(self.single_observation_space, num_envs)
+        self.action_space = gym.vector.utils.batch_space(self.single_action_space, num_envs)
+
+        autoreset = getattr(gym.vector, "AutoresetMode", None)
+        self.metadata = {"autoreset_mode": autoreset.SAME_STEP if autoreset else "same-step"}
+
+    def _out(self, array: np.ndarray) -> np.ndarray:
+        return array.copy() if self.copy else array
+
+    def reset(self, *, seed: Optional[Union[int, Sequence[int]]] = None, options=None):
+        """seed: None continues each env's piece sequence, an int seeds env i
+        with seed + i, or a sequence gives one seed per env."""
+        if seed is not None and not isinstance(seed, int):
+            seed = np.asarray(seed, dtype=np.uint32)
+        return self._out(self.core.reset(seed)), {}
+
+    def step(self, actions):
+        obs, rewards, terminated, truncated = self.core.step(np.asarray(actions, dtype=np.int32))
+        infos = {}
+        done = terminated | truncated
+        if done.any():
+            infos["final_obs"] = self.core.final_obs.copy()
+            infos["_final_obs"] = done.copy()
+            infos["episode"] = {
+                "r": self.core.final_scores.copy(),
+                "l": self.core.final_lengths.copy(),
+            }
+            infos["_episode"] = done.copy()
+        return self._out(obs), self._out(rewards), self._out(terminated), self._out(truncated), infos
+
+    def unpack(self, observations: np.ndarray) -> np.ndarray:
+        """Float32 [N, obs_dim] from stored rows of any obs_dtype."""
+        if self.obs_dtype == "packed":
+            return tinyrl_tetris.unpack_observations(observations, self.queue_size)
+        return np.asarray(observations, dtype=np.float32)
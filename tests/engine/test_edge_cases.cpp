@@ -92,7 +92,7 @@ TEST_CASE("Collision detection edge cases", "[tetris][edge][collision]") {
     
     SECTION("Collision with single cell") {
         // Place one cell on board
-        game.obs.board[10][5] = 1;
+        game.setCell(5, 10, 1);
         
         // Position piece to overlap
         game.current_x = 5;
@@ -107,7 +107,7 @@ TEST_CASE("Collision detection edge cases", "[tetris][edge][collision]") {
     SECTION("No collision when adjacent but not overlapping") {
         // Fill left side
         for (int y = 0; y < 5; y++) {
-            game.obs.board[y][0] = 1;
+            game.setCell(0, y, 1);
         }
         
         // Position piece next to filled area
@@ -132,7 +132,7 @@ TEST_CASE("Collision detection edge cases", "[tetris][edge][collision]") {
         // Fill entire board
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                game.obs.board[y][x] = 1;
+                game.setCell(x, y, 1);
             }
         }
         
@@ -160,8 +160,8 @@ TEST_CASE("Hard drop edge cases", "[tetris][edge][drop]") {
     SECTION("Hard drop onto existing pieces") {
         // Place obstacles at bottom
         for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            game.obs.board[0][x] = 1;
-            game.obs.board[1][x] = 1;
+            game.setCell(x, 0, 1);
+            game.setCell(x, 1, 1);
         }
         
         game.current_y = 10;
@@ -187,7 +187,7 @@ TEST_CASE("Line clearing edge cases", "[tetris][edge][lines]") {
         // Fill 4 consecutive lines (Tetris)
         for (int y = 0; y < 4; y++) {
             for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-                game.obs.board[y][x] = 1;
+                game.setCell(x, y, 1);
             }
         }
         
@@ -201,9 +201,9 @@ TEST_CASE("Line clearing edge cases", "[tetris][edge][lines]") {
     SECTION("Clear non-consecutive lines") {
         // Fill alternating lines
         for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            game.obs.board[0][x] = 1;
-            game.obs.board[2][x] = 1;
-            game.obs.board[4][x] = 1;
+            game.setCell(x, 0, 1);
+            game.setCell(x, 2, 1);
+            game.setCell(x, 4, 1);
         }
         
         game.current_y = 0;
@@ -215,9 +215,9 @@ TEST_CASE("Line clearing edge cases", "[tetris][edge][lines]") {
     SECTION("Partial line does not clear") {
         // Fill line except one cell
         for (int x = 0; x < Tetris::BOARD_WIDTH - 1; x++) {
-            game.obs.board[0][x] = 1;
+            game.setCell(x, 0, 1);
         }
-        game.obs.board[0][Tetris::BOARD_WIDTH - 1] = 0;  // One gap
+        game.setCell(Tetris::BOARD_WIDTH - 1, 0, 0);  // One gap
         
         game.current_y = 0;
         int cleared = game.clearLines();
@@ -229,7 +229,7 @@ TEST_CASE("Line clearing edge cases", "[tetris][edge][lines]") {
         // Fill top line
         int top_y = Observation::BoardH - 1;
         for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            game.obs.board[top_y][x] = 1;
+            game.setCell(x, top_y, 1);
         }
         
         game.current_y = top_y;
@@ -291,7 +291,7 @@ TEST_CASE("Swap/Hold edge cases", "[tetris][edge][swap]") {
         // Fill area where swapped piece would spawn
         for (int y = Observation::BoardH - 5; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                game.obs.board[y][x] = 1;
+                game.setCell(x, y, 1);
             }
         }
         
@@ -323,7 +323,7 @@ TEST_CASE("Game over conditions", "[tetris][edge][gameover]") {
         // Fill board to near top
         for (int y = 0; y < Observation::BoardH - 2; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                game.obs.board[y][x] = 1;
+                game.setCell(x, y, 1);
             }
         }
         
@@ -340,7 +340,7 @@ TEST_CASE("Game over conditions", "[tetris][edge][gameover]") {
         // Add some pieces
         for (int y = 0; y < 5; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                game.obs.board[y][x] = 1;
+                game.setCell(x, y, 1);
             }
         }
         
@@ -366,7 +366,7 @@ TEST_CASE("UpdateObservation edge cases", "[tetris][edge][observation]") {
         int active_count = 0;
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                if (game.obs.active_tetromino[y][x] != 0) {
+                if (game.getObservation().active_tetromino[y][x] != 0) {
                     active_count++;
                 }
             }
@@ -384,7 +384,7 @@ TEST_CASE("UpdateObservation edge cases", "[tetris][edge][observation]") {
         bool all_zero = true;
         for (int y = 0; y < Tetris::PIECE_SIZE; y++) {
             for (int x = 0; x < Tetris::PIECE_SIZE; x++) {
-                if (game.obs.holder[y][x] != 0) {
+                if (game.getObservation().holder[y][x] != 0) {
                     all_zero = false;
                 }
             }
@@ -397,7 +397,7 @@ TEST_CASE("UpdateObservation edge cases", "[tetris][edge][observation]") {
         game.updateObservation();
         
         // Verify queue size
-        REQUIRE(game.obs.queue.size() == game.queue_size * Tetris::PIECE_SIZE);
+        REQUIRE(game.getObservation().queue.size() == game.queue_size * Tetris::PIECE_SIZE);
         
         // All queue pieces should be valid
         for (size_t i = 0; i < game.queue.size(); i++) {
@@ -418,14 +418,14 @@ TEST_CASE("Piece locking edge cases", "[tetris][edge][lock]") {
         game.lockPiece();
         
         // Should lock without error
-        bool locked = (game.obs.board[0][0] != 0 || game.obs.board[0][1] != 0);
+        bool locked = (game.getObservation().board[0][0] != 0 || game.getObservation().board[0][1] != 0);
         REQUIRE(locked);
     }
     
     SECTION("Lock piece on top of cleared area") {
         // Create cleared area
         for (int x = 3; x < 7; x++) {
-            game.obs.board[5][x] = 0;
+            game.setCell(x, 5, 0);
         }
         
         // Lock piece above
@@ -0,0 +1,82 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "episodeLog.h"
+#include "tetrisGame.h"
+
+TEST_CASE("Episode log replays a seeded game exactly", "[episode_log]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 77);
+    EpisodeRecorder recorder(77, 3);
+    std::vector<GameState> states;
+
+    uint32_t state = 5;
+    for (int t = 0; t < 400 && !game.isGameOver(); t++) {
+        state = state * 1664525u + 1013904223u;
+        // Mostly NOOP runs, so run-length coding has something to do
+        const int action = (state >> 29) < 5 ? Action::NOOP : static_cast<int>((state >> 24) % 8);
+        game.step(action);
+        recorder.record(action, game);
+        states.push_back(game.snapshot());
+    }
+
+    const std::vector<uint8_t> data = recorder.serialize();
+    // Far smaller than one observation per step
+    REQUIRE(data.size() < EpisodeLog::HeaderSize + 6 * recorder.numSteps());
+
+    EpisodeReplayer replayer(data.data(), data.size());
+    REQUIRE(replayer.numSteps() == recorder.numSteps());
+    REQUIRE(replayer.header().seed == 77);
+    REQUIRE(replayer.verify() == -1);
+    REQUIRE(replayer.game().score == game.score);
+
+    SECTION("Seeking lands on the recorded states") {
+        for (size_t t : {size_t(10), size_t(3), size_t(states.size())}) {
+            REQUIRE(replayer.seek(t));
+            const GameState replayed = replayer.game().snapshot();
+            REQUIRE(std::memcmp(replayed.board_rows, states[t - 1].board_rows, sizeof(replayed.board_rows)) == 0);
+            REQUIRE(replayed.current_piece_type == states[t - 1].current_piece_type);
+        }
+        REQUIRE_FALSE(replayer.seek(states.size() + 1));
+    }
+
+    SECTION("Checksums catch divergence") {
+        std::vector<uint8_t> corrupt = data;
+        corrupt[corrupt.size() - 4 * 20] ^= 1;  // checksum of step numSteps() - 20
+        EpisodeReplayer diverged(corrupt.data(), corrupt.size());
+        REQUIRE(diverged.verify() == static_cast<int64_t>(recorder.numSteps()) - 20);
+    }
+
+    SECTION("Malformed logs are rejected") {
+        REQUIRE_THROWS_AS(EpisodeReplayer(data.data(), EpisodeLog::HeaderSize - 1), std::invalid_argument);
+        REQUIRE_THROWS_AS(EpisodeReplayer(data.data(), data.size() - 1), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Episode log replays placements from a snapshot", "[episode_log]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 8);
+    for (int i = 0; i < 4; i++) {
+        game.step(Action::DROP);
+    }
+    EpisodeRecorder recorder(game, ActionMode::PLACEMENT, true, 8);
+
+    for (int t = 0; t < 60 && !game.isGameOver(); t++) {
+        const size_t count = game.enumeratePlacements(true).size();
+        const int index = static_cast<int>((t * 7) % count);
+        game.stepPlacement(index);
+        recorder.record(index, game);
+    }
+
+    const std::vector<uint8_t> data = recorder.serialize();
+    EpisodeReplayer replayer(data.data(), data.size());
+    REQUIRE(replayer.header().flags & EpisodeLog::HasStartState);
+    REQUIRE(replayer.verify() == -1);
+    REQUIRE(EpisodeLog::checksum(replayer.game()) == EpisodeLog::checksum(game));
+}
+
+TEST_CASE("Episode logs need a queue that fits in a snapshot", "[episode_log]") {
+    const uint8_t queue_size = GameState::MaxQueue + 1;
+    REQUIRE_THROWS_AS(EpisodeRecorder(1, queue_size), std::invalid_argument);
+    TetrisGame game(TimeManager::SIMULATION, queue_size, 1);
+    REQUIRE_THROWS_AS(EpisodeRecorder(game), std::invalid_argument);
+}
@@ -0,0 +1,84 @@
+#include <catch2/catch_test_macros.hpp>
+#include <vector>
+#include "fixedTetris.h"
+#include "tetrisGame.h"
+
+TEST_CASE("FixedTetris<10, 20, 3> matches TetrisGame", "[fixed][step]") {
+    for (PieceRandomizer randomizer : {PieceRandomizer::UNIFORM, PieceRandomizer::BAG7}) {
+        Tetris10x20 fixed(31, randomizer);
+        TetrisGame game(TimeManager::SIMULATION, 3, 31, randomizer);
+        std::vector<uint8_t> rendered(Tetris10x20::ObsSize);
+
+        uint32_t state = 99;
+        size_t mismatches = 0;
+        for (int t = 0; t < 3000; t++) {
+            state = state * 1664525u + 1013904223u;
+            const int action = static_cast<int>((state >> 24) % 9);
+            const StepResult expected = game.step(action);
+            const StepResult result = fixed.step(action);
+            mismatches += result.reward != expected.reward;
+            mismatches += result.terminated != expected.terminated;
+            mismatches += fixed.score != game.score;
+            mismatches += fixed.current_x != game.current_x;
+            mismatches += fixed.current_y != game.current_y;
+            mismatches += fixed.rotation != game.rotation;
+            mismatches += fixed.current_piece_type != game.current_piece_type;
+
+            if (t % 7 == 0) {
+                // Same planes, minus the padding columns
+                fixed.writeObservation(rendered.data());
+                const Observation& obs = game.getObservation();
+                const uint8_t* active = rendered.data();
+                const uint8_t* board = active + Tetris10x20::Rows * Tetris10x20::Width;
+                for (int y = 0; y < Observation::BoardH; y++) {
+                    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+                        mismatches += active[y * Tetris10x20::Width + x] != obs.active_tetromino[y][x];
+                        mismatches += board[y * Tetris10x20::Width + x] != obs.board[y][x];
+                    }
+                }
+                const uint8_t* pieces = board + Tetris10x20::Rows * Tetris10x20::Width;
+                const uint8_t* expected_pieces = obs.holder.data;
+                for (int i = 0; i < 4 * Tetris10x20::PieceCells; i++) {
+                    mismatches += pieces[i] != expected_pieces[i];
+                }
+            }
+
+            if (expected.terminated) {
+                game.reset();
+                fixed.reset();
+            }
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("FixedTetris mini board", "[fixed]") {
+    Tetris6x12 game(5);
+    REQUIRE(Tetris6x12::ObsSize == 2 * 16 * 6 + 4 * 16);
+    REQUIRE_FALSE(game.isGameOver());
+
+    SECTION("A horizontal I piece clears a row") {
+        game.setCell(0, 0, 1);
+        game.setCell(1, 0, 1);
+        game.current_piece_type = 0;
+        game.rotation = 0;
+        const StepResult result = game.step(Action::DROP);
+        REQUIRE(result.reward == 1.0f);
+        REQUIRE(game.score == 1);
+        REQUIRE(game.getCell(0, 0) == 0);
+        REQUIRE(game.column_heights[0] == 0);
+    }
+
+    SECTION("Hard drops top out within the short board") {
+        int pieces = 0;
+        while (!game.isGameOver()) {
+            game.step(Action::DROP);
+            pieces++;
+        }
+        // 6 x 12 holds 18 pieces; stacking in the middle tops out far sooner
+        REQUIRE(pieces <= 18);
+        for (int y = 0; y < Tetris6x12::Rows; y++) {
+            REQUIRE((game.board_rows[y] & Tetris6x12::EmptyRow) == Tetris6x12::EmptyRow);
+        }
+    }
+}
@@ -0,0 +1,43 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+#include "heuristicAgent.h"
+#include "pieceTables.h"
+#include "tetrisGame.h"
+
+TEST_CASE("Heuristic agent scores placements with its weights", "[heuristic]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 21);
+    for (int i = 0; i < 6; i++) {
+        game.step(Action::DROP);
+    }
+    const std::vector<Placement> placements = game.enumeratePlacements();
+    REQUIRE_FALSE(placements.empty());
+
+    HeuristicAgent agent;
+    std::vector<float> scores(placements.size());
+    agent.scorePlacements(placements, scores.data());
+
+    // Same sum, one placement at a time
+    const LinearValue value = LinearValue::elTetris();
+    float row[TetrisGame::AfterstateSize];
+    for (size_t i = 0; i < placements.size(); i++) {
+        const Placement& p = placements[i];
+        const Tetris::PieceShape& shape = Tetris::PIECE_TABLE.shapes[p.piece_type][p.rotation];
+        TetrisGame::writeAfterstate(p, row);
+        const float expected = value(row) +
+            HeuristicAgent::ElTetrisLandingHeight * (p.y + 0.5f * (shape.min_y + shape.max_y));
+        REQUIRE(std::fabs(scores[i] - expected) < 1e-3f);
+    }
+}
+
+TEST_CASE("Heuristic agent clears lines and survives", "[heuristic]") {
+    HeuristicAgent agent;
+    TetrisGame game(TimeManager::SIMULATION, 3, 3);
+    const HeuristicAgent::GameStats stats = agent.play(game, 500);
+
+    REQUIRE(stats.pieces == 500);
+    REQUIRE_FALSE(stats.topped_out);
+    // 500 pieces are 2000 cells; a surviving board must have cleared most of them
+    REQUIRE(stats.lines >= 180);
+    REQUIRE(static_cast<int>(stats.lines) == game.score);
+}
@@ -0,0 +1,31 @@
+#include <catch2/catch_test_macros.hpp>
+#include <atomic>
+#include <cstdint>
+#include <cstring>
+#include "hostTuning.h"
+#include "workerPool.h"
+
+TEST_CASE("Huge-page buffers are aligned, zeroed and writable", "[host_tuning]") {
+    const size_t bytes = (size_t{3} << 20) + 100;
+    uint8_t* data = static_cast<uint8_t*>(allocateHugePages(bytes));
+    if (!data) {
+        SUCCEED("no huge-page support on this platform");
+        return;
+    }
+    REQUIRE(reinterpret_cast<uintptr_t>(data) % (size_t{2} << 20) == 0);
+    REQUIRE(data[0] == 0);
+    REQUIRE(data[bytes - 1] == 0);
+    std::memset(data, 0xAB, bytes);
+    REQUIRE(data[bytes - 1] == 0xAB);
+    freeHugePages(data, bytes);
+}
+
+TEST_CASE("Pinned pool threads still run every range", "[host_tuning]") {
+    const std::vector<int> cpus = allowedCpus();
+    REQUIRE_FALSE(cpus.empty());
+
+    WorkerPool pool(3, cpus);
+    std::atomic<size_t> total{0};
+    pool.parallelFor(100, [&](size_t, size_t begin, size_t end) { total += end - begin; });
+    REQUIRE(total == 100);
+}
@@ -0,0 +1,122 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cmath>
+#include <vector>
+#include "mlpPolicy.h"
+
+namespace {
+
+MlpPolicy::Layer randomLayer(size_t inputs, size_t outputs, PieceRng& rng) {
+    MlpPolicy::Layer layer;
+    layer.inputs = inputs;
+    layer.outputs = outputs;
+    for (size_t i = 0; i < inputs * outputs; i++) {
+        layer.weights.push_back(static_cast<float>(rng() % 2001) / 1000.0f - 1.0f);
+    }
+    for (size_t o = 0; o < outputs; o++) {
+        layer.bias.push_back(static_cast<float>(rng() % 201) / 1000.0f - 0.1f);
+    }
+    return layer;
+}
+
+// Straightforward reference for one row
+std::vector<float> reference(const MlpPolicy::Layer& layer, const std::vector<float>& in, bool apply_tanh) {
+    std::vector<float> out(layer.outputs);
+    for (size_t o = 0; o < layer.outputs; o++) {
+        double sum = layer.bias[o];
+        for (size_t i = 0; i < layer.inputs; i++) {
+            sum += static_cast<double>(layer.weights[o * layer.inputs + i]) * in[i];
+        }
+        out[o] = static_cast<float>(apply_tanh ? std::tanh(sum) : sum);
+    }
+    return out;
+}
+
+}  // namespace
+
+TEST_CASE("MlpPolicy forward matches a reference pass", "[mlp_policy]") {
+    // Odd sizes exercise the vector tails and the row-block remainder
+    const size_t inputs = 37;
+    const size_t hidden = 19;
+    const size_t actions = 7;
+    const size_t rows = 6;
+    PieceRng rng(5);
+    const MlpPolicy::Layer h1 = randomLayer(inputs, hidden, rng);
+    const MlpPolicy::Layer h2 = randomLayer(hidden, hidden, rng);
+    const MlpPolicy::Layer actor = randomLayer(hidden, actions, rng);
+    const MlpPolicy::Layer critic = randomLayer(hidden, 1, rng);
+    const MlpPolicy policy({h1, h2}, actor, critic);
+    REQUIRE(policy.inputSize() == inputs);
+    REQUIRE(policy.numActions() == actions);
+
+    std::vector<float> obs(rows * inputs);
+    for (float& x : obs) {
+        x = static_cast<float>(rng() % 8);
+    }
+    std::vector<float> logits(rows * actions);
+    std::vector<float> values(rows);
+    MlpPolicy::Scratch scratch;
+    policy.forward(obs.data(), rows, logits.data(), values.data(), scratch);
+
+    size_t mismatches = 0;
+    for (size_t r = 0; r < rows; r++) {
+        const std::vector<float> row(obs.begin() + r * inputs, obs.begin() + (r + 1) * inputs);
+        const std::vector<float> features = reference(h2, reference(h1, row, true), true);
+        const std::vector<float> expected_logits = reference(actor, features, false);
+        for (size_t a = 0; a < actions; a++) {
+            mismatches += std::fabs(logits[r * actions + a] - expected_logits[a]) > 1e-4f;
+        }
+        mismatches += std::fabs(values[r] - reference(critic, features, false)[0]) > 1e-4f;
+    }
+    REQUIRE(mismatches == 0);
+}
+
+TEST_CASE("MlpPolicy samples from softmax(logits)", "[mlp_policy]") {
+    // No hidden layers and zero weights: the logits are the actor bias
+    MlpPolicy::Layer actor{2, 3, std::vector<float>(6, 0.0f), {0.0f, std::log(2.0f), std::log(5.0f)}};
+    MlpPolicy::Layer critic{2, 1, {0.0f, 0.0f}, {1.5f}};
+    const MlpPolicy policy({}, actor, critic);
+
+    PieceRng rng(11);
+    PieceRng* rngs[1] = {&rng};
+    MlpPolicy::Scratch scratch;
+    const float obs[2] = {1.0f, 2.0f};
+    std::vector<int> counts(3, 0);
+    const int draws = 40000;
+    for (int i = 0; i < draws; i++) {
+        MlpPolicy::Sample sample;
+        policy.act(obs, 1, rngs, &sample, scratch);
+        counts[sample.action]++;
+        REQUIRE(sample.value == 1.5f);
+        REQUIRE(std::fabs(sample.log_prob - std::log(sample.action == 0 ? 0.125f : sample.action == 1 ? 0.25f : 0.625f))
+                < 1e-5f);
+    }
+    REQUIRE(std::abs(counts[0] - draws / 8) < draws / 50);
+    REQUIRE(std::abs(counts[1] - draws / 4) < draws / 50);
+}
+
+TEST_CASE("MlpPolicy rejects shapes that don't chain", "[mlp_policy]") {
+    PieceRng rng(1);
+    REQUIRE_THROWS(MlpPolicy({randomLayer(4, 8, rng)}, randomLayer(6, 3, rng), randomLayer(8, 1, rng)));
+    REQUIRE_THROWS(MlpPolicy({randomLayer(4, 8, rng)}, randomLayer(8, 3, rng), randomLayer(8, 2, rng)));
+}
+
+TEST_CASE("MlpPolicy scratch sizes values by rows alone", "[mlp_policy]") {
+    // One scratch across policies, as collector workers keep theirs when
+    // the weights are swapped: fewer actions but more rows than before
+    PieceRng rng(5);
+    const MlpPolicy wide({}, randomLayer(2, 7, rng), randomLayer(2, 1, rng));
+    const MlpPolicy narrow({}, randomLayer(2, 2, rng), randomLayer(2, 1, rng));
+    MlpPolicy::Scratch scratch;
+    PieceRng rng0(1), rng1(2), rng2(3);
+    PieceRng* rngs[3] = {&rng0, &rng1, &rng2};
+    const float obs[6] = {0.5f, -0.5f, 1.0f, 0.0f, -1.0f, 2.0f};
+    MlpPolicy::Sample samples[3];
+
+    wide.act(obs, 1, rngs, samples, scratch);
+    narrow.act(obs, 3, rngs, samples, scratch);
+    REQUIRE(scratch.values.size() >= 3);
+    for (const MlpPolicy::Sample& sample : samples) {
+        REQUIRE(sample.action >= 0);
+        REQUIRE(sample.action < 2);
+    }
+}
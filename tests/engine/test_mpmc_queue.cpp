@@ -0,0 +1,75 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <thread>
+#include <vector>
+#include "mpmcQueue.h"
+
+TEST_CASE("MpmcQueue is bounded and FIFO", "[mpmc_queue]") {
+    MpmcQueue<int> queue(5);
+    REQUIRE(queue.capacity() == 8);
+
+    int value = 0;
+    REQUIRE_FALSE(queue.tryPop(value));
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(queue.tryPush(i));
+    }
+    REQUIRE_FALSE(queue.tryPush(8));
+    for (int i = 0; i < 8; i++) {
+        REQUIRE(queue.tryPop(value));
+        REQUIRE(value == i);
+    }
+    REQUIRE_FALSE(queue.tryPop(value));
+
+    // Closing drains what is left, then stops waiting
+    REQUIRE(queue.push(42));
+    queue.close();
+    REQUIRE(queue.pop(value));
+    REQUIRE(value == 42);
+    REQUIRE_FALSE(queue.pop(value));
+}
+
+TEST_CASE("MpmcQueue hands every item to exactly one consumer", "[mpmc_queue]") {
+    // Small capacity so producers and consumers both end up parking
+    MpmcQueue<uint64_t> queue(4);
+    const uint64_t per_producer = 20000;
+    const int producers = 3;
+    const int consumers = 3;
+
+    std::vector<std::thread> threads;
+    std::vector<uint64_t> sums(consumers, 0);
+    std::vector<uint64_t> counts(consumers, 0);
+    for (int p = 0; p < producers; p++) {
+        threads.emplace_back([&, p] {
+            for (uint64_t i = 0; i < per_producer; i++) {
+                queue.push(i * producers + p + 1);
+            }
+        });
+    }
+    for (int c = 0; c < consumers; c++) {
+        threads.emplace_back([&, c] {
+            uint64_t value = 0;
+            while (queue.pop(value)) {
+                sums[c] += value;
+                counts[c]++;
+            }
+        });
+    }
+    for (int p = 0; p < producers; p++) {
+        threads[p].join();
+    }
+    // Producers are done; consumers drain the rest and then see the close
+    queue.close();
+    for (int c = 0; c < consumers; c++) {
+        threads[producers + c].join();
+    }
+
+    const uint64_t total = per_producer * producers;
+    uint64_t sum = 0;
+    uint64_t count = 0;
+    for (int c = 0; c < consumers; c++) {
+        sum += sums[c];
+        count += counts[c];
+    }
+    REQUIRE(count == total);
+    REQUIRE(sum == total * (total + 1) / 2);
+}
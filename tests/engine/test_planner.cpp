@@ -0,0 +1,76 @@
+#include <catch2/catch_test_macros.hpp>
+#include <stdexcept>
+#include "planner.h"
+#include "tetrisGame.h"
+
+namespace {
+
+int playPlanned(TetrisPlanner& planner, uint32_t seed, int max_pieces) {
+    TetrisGame game(TimeManager::SIMULATION, 3, seed);
+    int pieces = 0;
+    while (!game.isGameOver() && pieces < max_pieces) {
+        const PlanResult result = planner.plan(game.snapshot());
+        const std::vector<Placement>& placements = game.enumeratePlacements(planner.config().use_hold);
+        REQUIRE(result.placement >= 0);
+        REQUIRE(static_cast<size_t>(result.placement) < placements.size());
+        REQUIRE(result.root_scores.size() == placements.size());
+        game.stepPlacement(result.placement);
+        pieces++;
+    }
+    return pieces;
+}
+
+}  // namespace
+
+TEST_CASE("Planner keeps the game alive", "[planner]") {
+    PlannerConfig config;
+    config.num_threads = 2;
+    config.depth = 2;
+    config.beam_width = 8;
+    config.simulations = 64;
+
+    SECTION("Beam search") {
+        config.algorithm = PlannerConfig::BEAM;
+        TetrisPlanner planner(config);
+        REQUIRE(playPlanned(planner, 5, 100) == 100);
+    }
+
+    SECTION("MCTS") {
+        config.algorithm = PlannerConfig::MCTS;
+        TetrisPlanner planner(config);
+        REQUIRE(playPlanned(planner, 5, 100) == 100);
+    }
+}
+
+TEST_CASE("Planner search is reproducible across thread counts", "[planner]") {
+    PlannerConfig config;
+    config.depth = 2;
+    config.beam_width = 8;
+    TetrisGame game(TimeManager::SIMULATION, 3, 11);
+    for (int i = 0; i < 10; i++) {
+        game.step(Action::DROP);
+    }
+    const GameState root = game.snapshot();
+
+    config.num_threads = 1;
+    TetrisPlanner serial(config);
+    config.num_threads = 3;
+    TetrisPlanner threaded(config);
+    const PlanResult a = serial.plan(root);
+    const PlanResult b = threaded.plan(root);
+
+    // Same seed and plan count, so the same sampled futures
+    REQUIRE(a.placement == b.placement);
+    REQUIRE(a.value == b.value);
+    REQUIRE(a.root_scores == b.root_scores);
+    REQUIRE(a.pieces_simulated == b.pieces_simulated);
+
+    TetrisPlanner wrong_queue(config, 5);
+    REQUIRE_THROWS_AS(wrong_queue.plan(root), std::invalid_argument);
+}
+
+TEST_CASE("Planner needs a queue that fits in a snapshot", "[planner]") {
+    PlannerConfig config;
+    config.num_threads = 1;
+    REQUIRE_THROWS_AS(TetrisPlanner(config, GameState::MaxQueue + 1), std::invalid_argument);
+}
@@ -0,0 +1,157 @@
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <new>
+#include <random>
+#include "tetrisGame.h"
+#include "constants.h"
+
+// Count every heap allocation made by the test binary so the steady-state
+// step loop can be checked for zero allocations. This replaces the global
+// allocator, so the file is built as its own executable (tetris_alloc_tests).
+// Every form of new/delete is replaced so none of them falls through to a
+// sanitizer's allocator and gets paired with free() here.
+namespace {
+size_t g_allocations = 0;
+}
+
+void* operator new(std::size_t size) {
+    g_allocations++;
+    if (void* ptr = std::malloc(size ? size : 1)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size, std::align_val_t align) {
+    g_allocations++;
+    const size_t alignment = static_cast<size_t>(align);
+    const size_t rounded = (size + alignment - 1) / alignment * alignment;
+    if (void* ptr = std::aligned_alloc(alignment, rounded ? rounded : alignment)) {
+        return ptr;
+    }
+    throw std::bad_alloc();
+}
+
+void operator delete(void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size, const std::nothrow_t&) noexcept {
+    g_allocations++;
+    return std::malloc(size ? size : 1);
+}
+
+void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void* operator new[](std::size_t size) {
+    return operator new(size);
+}
+
+void* operator new[](std::size_t size, const std::nothrow_t& tag) noexcept {
+    return operator new(size, tag);
+}
+
+void operator delete[](void* ptr) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void* operator new[](std::size_t size, std::align_val_t align) {
+    return operator new(size, align);
+}
+
+void operator delete[](void* ptr, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::size_t, std::align_val_t) noexcept {
+    std::free(ptr);
+}
+
+void* operator new(std::size_t size, std::align_val_t align, const std::nothrow_t&) noexcept {
+    try {
+        return operator new(size, align);
+    } catch (const std::bad_alloc&) {
+        return nullptr;
+    }
+}
+
+void* operator new[](std::size_t size, std::align_val_t align, const std::nothrow_t& tag) noexcept {
+    return operator new(size, align, tag);
+}
+
+void operator delete(void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+void operator delete[](void* ptr, std::align_val_t, const std::nothrow_t&) noexcept {
+    std::free(ptr);
+}
+
+TEST_CASE("Step does not allocate in steady state", "[tetris][step][alloc]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 1234);
+    std::mt19937 action_rng(42);
+
+    // Warm up outside the measured window
+    for (int i = 0; i < 100; i++) {
+        game.step(static_cast<int>(action_rng() % 8));
+    }
+
+    SECTION("Random play including resets") {
+        size_t before = g_allocations;
+        for (int i = 0; i < 20000; i++) {
+            StepResult result = game.step(static_cast<int>(action_rng() % 8));
+            game.getObservation();
+            if (result.terminated) {
+                game.reset();
+            }
+        }
+        size_t allocations = g_allocations - before;
+        REQUIRE(allocations == 0);
+    }
+
+    SECTION("Line clears") {
+        game.reset();
+        // Two full rows except where the O-piece will land (columns 4-5)
+        for (int y = 0; y < 2; y++) {
+            for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+                if (x != 4 && x != 5) {
+                    game.setCell(x, y, 1);
+                }
+            }
+        }
+        game.current_piece_type = 1;  // O-piece, filled columns 1-2 of its box
+        game.rotation = 0;
+        game.current_x = 3;
+        game.current_y = 5;
+
+        size_t before = g_allocations;
+        StepResult result = game.step(static_cast<int>(Action::DROP));
+        size_t allocations = g_allocations - before;
+
+        REQUIRE(allocations == 0);
+        // The rewards themselves are checked in test_tetris_game.cpp
+        REQUIRE(result.reward == 2.0f);
+    }
+}
@@ -2,18 +2,24 @@
 #include <catch2/catch_test_macros.hpp>
 #include "tetrisGame.h"
 #include "constants.h"
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+#include <vector>
 
 TEST_CASE("TetrisGame initialization", "[tetris][init]") {
     TetrisGame game(TimeManager::SIMULATION, 3);
     
     SECTION("Board is initialized to empty") {
         // Board should be empty (all zeros)
-        REQUIRE(game.obs.board.size() == Observation::BoardH);
-        REQUIRE(game.obs.board[0].size() == Observation::BoardW);
+        REQUIRE(game.getObservation().board.size() == Observation::BoardH);
+        REQUIRE(game.getObservation().board[0].size() == Observation::BoardW);
         
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                REQUIRE(game.obs.board[y][x] == 0);
+                REQUIRE(game.getObservation().board[y][x] == 0);
             }
         }
     }
@@ -23,8 +29,8 @@ TEST_CASE("TetrisGame initialization", "[tetris][init]") {
     }
     
     SECTION("Active tetromino is initialized") {
-        REQUIRE(game.obs.active_tetromino.size() == Observation::BoardH);
-        REQUIRE(game.obs.active_tetromino[0].size() == Observation::BoardW);
+        REQUIRE(game.getObservation().active_tetromino.size() == Observation::BoardH);
+        REQUIRE(game.getObservation().active_tetromino[0].size() == Observation::BoardW);
     }
 }
 
@@ -102,7 +108,7 @@ TEST_CASE("Collision detection", "[tetris][collision]") {
     
     SECTION("Collision with locked piece") {
         // Place a piece on the board
-        game.obs.board[5][5] = 1;
+        game.setCell(5, 5, 1);
         
         // Move current piece to overlap
         game.current_x = 5;
@@ -125,13 +131,57 @@ TEST_CASE("Hard drop", "[tetris][drop]") {
     }
 }
 
+TEST_CASE("Column heights and ghost piece", "[tetris][drop]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 11);
+    uint32_t state = 99;
+
+    for (int i = 0; i < 3000; i++) {
+        state = state * 1664525u + 1013904223u;
+        game.step(static_cast<int>((state >> 24) % 8));
+        if (game.isGameOver()) {
+            game.reset();
+        }
+
+        // Heights agree with the cells
+        size_t mismatches = 0;
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+            int height = 0;
+            for (int y = 0; y < Observation::BoardH; y++) {
+                if (game.getCell(x, y)) height = y + 1;
+            }
+            mismatches += game.getColumnHeights()[x] != height;
+        }
+        REQUIRE(mismatches == 0);
+
+        // Ghost agrees with a step-by-step drop
+        const int8_t start_y = game.current_y;
+        while (!game.checkCollision()) {
+            game.current_y -= 1;
+        }
+        const int scanned = game.current_y + 1;
+        game.current_y = start_y;
+        REQUIRE(game.getGhostY() == scanned);
+    }
+}
+
+TEST_CASE("Ghost piece under an overhang", "[tetris][drop]") {
+    TetrisGame game(TimeManager::SIMULATION, 3);
+    game.setCell(0, 10, 1);
+    game.current_piece_type = 1;  // O-piece, columns 1-2 of its box
+    game.rotation = 0;
+    game.current_x = -1;
+    game.current_y = 5;
+    REQUIRE(game.getColumnHeights()[0] == 11);
+    REQUIRE(game.getGhostY() == 0);
+}
+
 TEST_CASE("Line clearing", "[tetris][lines]") {
     TetrisGame game(TimeManager::SIMULATION, 3);
     
     SECTION("Clear single line") {
         // Fill a complete line
         for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
-            game.obs.board[0][x] = 1;
+            game.setCell(x, 0, 1);
         }
         
         int cleared = game.clearLines();
@@ -177,7 +227,7 @@ TEST_CASE("Observation update", "[tetris][observation]") {
         bool has_active_piece = false;
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                if (game.obs.active_tetromino[y][x] != 0) {
+                if (game.getObservation().active_tetromino[y][x] != 0) {
                     has_active_piece = true;
                     break;
                 }
@@ -191,7 +241,7 @@ TEST_CASE("Observation update", "[tetris][observation]") {
         game.updateObservation();
         
         // Queue should show upcoming pieces
-        REQUIRE(game.obs.queue.size() > 0);
+        REQUIRE(game.getObservation().queue.size() > 0);
     }
 }
 
@@ -213,6 +263,44 @@ TEST_CASE("Step function", "[tetris][step]") {
     }
 }
 
+// step() removes full rows as soon as they lock and rewards them once.
+// Before, they stayed on the board and the last non-zero reward repeated
+// on every later step.
+TEST_CASE("Step rewards lines once, on the step that clears them", "[tetris][step][lines]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 1234);
+    // Rows 0 and 1 full except where the O-piece lands (columns 4-5), and a
+    // marker on row 2 that must come down to row 0
+    for (int y = 0; y < 2; y++) {
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+            if (x != 4 && x != 5) {
+                game.setCell(x, y, 1);
+            }
+        }
+    }
+    game.setCell(0, 2, 1);
+    game.current_piece_type = 1;  // O-piece, filled columns 1-2 of its box
+    game.rotation = 0;
+    game.current_x = 3;
+    game.current_y = 5;
+
+    StepResult result = game.step(static_cast<int>(Action::DROP));
+    REQUIRE(result.reward == 2.0f);
+    REQUIRE(game.score == 2);
+    REQUIRE(game.getCell(0, 0) != 0);
+    for (int x = 1; x < Tetris::BOARD_WIDTH; x++) {
+        REQUIRE(game.getCell(x, 0) == 0);
+    }
+    for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+        REQUIRE(game.getCell(x, 1) == 0);
+    }
+
+    for (int i = 0; i < 5; i++) {
+        result = game.step(static_cast<int>(Action::NOOP));
+        REQUIRE(result.reward == 0.0f);
+    }
+    REQUIRE(game.score == 2);
+}
+
 TEST_CASE("Piece locking", "[tetris][lock]") {
     TetrisGame game(TimeManager::SIMULATION, 3);
     
@@ -227,7 +315,7 @@ TEST_CASE("Piece locking", "[tetris][lock]") {
         int count_before = 0;
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                if (game.obs.board[y][x] != 0) count_before++;
+                if (game.getObservation().board[y][x] != 0) count_before++;
             }
         }
         
@@ -237,7 +325,7 @@ TEST_CASE("Piece locking", "[tetris][lock]") {
         int count_after = 0;
         for (int y = 0; y < Observation::BoardH; y++) {
             for (int x = 0; x < Observation::BoardW; x++) {
-                if (game.obs.board[y][x] != 0) count_after++;
+                if (game.getObservation().board[y][x] != 0) count_after++;
             }
         }
         
@@ -245,3 +333,325 @@ TEST_CASE("Piece locking", "[tetris][lock]") {
         REQUIRE(count_after > count_before);
     }
 }
+
+TEST_CASE("Observation buffer layout", "[tetris][observation]") {
+    TetrisGame game(TimeManager::SIMULATION, 3);
+    const Observation& obs = game.getObservation();
+
+    SECTION("Planes are contiguous in flattening order") {
+        const uint8_t* base = obs.data();
+        REQUIRE(obs.active_tetromino.data == base);
+        REQUIRE(obs.board.data == base + Observation::BoardH * Observation::BoardW);
+        REQUIRE(obs.holder.data == obs.board.data + Observation::BoardH * Observation::BoardW);
+        REQUIRE(obs.queue.data == obs.holder.data + Tetris::PIECE_SIZE * Tetris::PIECE_SIZE);
+        REQUIRE(obs.size() == 928);
+    }
+
+    SECTION("Buffer is cache-line aligned") {
+        REQUIRE(reinterpret_cast<uintptr_t>(obs.data()) % Observation::Alignment == 0);
+    }
+
+    SECTION("Copies own their storage") {
+        Observation copy = obs;
+        REQUIRE(copy.data() != obs.data());
+        REQUIRE(copy.board.data == copy.data() + Observation::BoardH * Observation::BoardW);
+        for (size_t i = 0; i < obs.size(); i++) {
+            REQUIRE(copy.data()[i] == obs.data()[i]);
+        }
+    }
+}
+
+TEST_CASE("Incremental observation matches a full render", "[tetris][observation]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 7);
+    uint32_t state = 12345;
+
+    for (int i = 0; i < 2000; i++) {
+        state = state * 1664525u + 1013904223u;
+        StepResult result = game.step(static_cast<int>((state >> 24) % 8));
+        if (result.terminated) {
+            game.reset();
+        }
+        // Only read sometimes so changes accumulate between refreshes
+        if (i % 7 != 0) {
+            continue;
+        }
+        Observation incremental = game.getObservation();
+        game.updateObservation();
+        const Observation& full = game.getObservation();
+        size_t mismatches = 0;
+        for (size_t j = 0; j < full.size(); j++) {
+            mismatches += incremental.data()[j] != full.data()[j];
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("Packed observations unpack to the same cells", "[tetris][observation]") {
+    for (int queue_size : {1, 3, 5}) {
+        TetrisGame game(TimeManager::SIMULATION, queue_size, 11);
+        const size_t packed_size = Observation::packedSize(queue_size);
+        const size_t obs_size = game.getObservation().size();
+        REQUIRE(packed_size * 8 < obs_size * 3);  // mask planes at 1 bit, board at 4
+
+        // Several observations back to back, as the collector stores them
+        const int count = 40;
+        std::vector<uint8_t> packed(count * packed_size);
+        std::vector<uint8_t> cells(count * obs_size);
+        for (int n = 0; n < count; n++) {
+            game.step(n % 3 == 0 ? Action::SWAP : Action::DROP);
+            const Observation& obs = game.getObservation();
+            REQUIRE(obs.pack(packed.data() + n * packed_size) == packed_size);
+            std::memcpy(cells.data() + n * obs_size, obs.data(), obs_size);
+        }
+
+        std::vector<float> unpacked(count * obs_size);
+        Observation::unpack(packed.data(), count, queue_size, unpacked.data());
+        size_t mismatches = 0;
+        for (size_t i = 0; i < cells.size(); i++) {
+            mismatches += unpacked[i] != static_cast<float>(cells[i]);
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("Board features track the board", "[tetris][features]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 5);
+    uint32_t state = 4242;
+
+    for (int i = 0; i < 3000; i++) {
+        state = state * 1664525u + 1013904223u;
+        game.step(static_cast<int>((state >> 24) % 8));
+        if (game.isGameOver()) {
+            game.reset();
+        }
+        if (i % 3 != 0) {
+            continue;  // let changes pile up between refreshes
+        }
+
+        // Recompute everything from the cells
+        int heights[Tetris::BOARD_WIDTH];
+        int holes = 0, col_transitions = 0, row_transitions = 0;
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+            heights[x] = 0;
+            bool prev = true;
+            for (int y = 0; y < Tetris::BOARD_HEIGHT; y++) {
+                const bool filled = game.getCell(x, y) != 0;
+                if (filled) heights[x] = y + 1;
+                col_transitions += filled != prev;
+                prev = filled;
+            }
+            for (int y = 0; y < heights[x]; y++) {
+                holes += game.getCell(x, y) == 0;
+            }
+        }
+        for (int y = 0; y < Tetris::BOARD_HEIGHT; y++) {
+            bool prev = true;
+            for (int x = 0; x <= Tetris::BOARD_WIDTH; x++) {
+                const bool filled = x == Tetris::BOARD_WIDTH || game.getCell(x, y) != 0;
+                row_transitions += filled != prev;
+                prev = filled;
+            }
+        }
+        int bumpiness = 0;
+        for (int x = 0; x + 1 < Tetris::BOARD_WIDTH; x++) {
+            bumpiness += std::abs(heights[x] - heights[x + 1]);
+        }
+
+        const BoardFeatures& f = game.getFeatures();
+        size_t mismatches = 0;
+        for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+            mismatches += f.heights[x] != heights[x];
+        }
+        mismatches += f.total_holes != holes;
+        mismatches += f.total_column_transitions != col_transitions;
+        mismatches += f.row_transitions != row_transitions;
+        mismatches += f.bumpiness != bumpiness;
+        REQUIRE(mismatches == 0);
+    }
+
+    SECTION("Feature vector has a fixed size") {
+        std::vector<float> features(game.featureSize());
+        REQUIRE(game.writeFeatures(features.data()) == features.size());
+        REQUIRE(TetrisGame::featureSize(3) == 68);
+    }
+}
+
+TEST_CASE("Placement enumeration", "[tetris][placement]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 21);
+    uint32_t state = 777;
+
+    SECTION("Empty board offers every column and rotation") {
+        const std::vector<Placement>& placements = game.enumeratePlacements();
+        REQUIRE_FALSE(placements.empty());
+        for (const Placement& p : placements) {
+            REQUIRE(p.piece_type == game.current_piece_type);
+            REQUIRE_FALSE(p.use_hold);
+            REQUIRE(p.lines_cleared == 0);
+            REQUIRE(p.features.aggregate_height > 0);
+        }
+        // 9 O positions, 17 I (10 + 7), up to 34 for the others
+        REQUIRE(placements.size() >= 9);
+        REQUIRE(placements.size() <= 34);
+    }
+
+    SECTION("Committed placements match their afterstates") {
+        int pieces = 0;
+        for (int i = 0; i < 400; i++) {
+            const std::vector<Placement>& placements = game.enumeratePlacements(true, true);
+            if (placements.empty()) {
+                game.reset();
+                continue;
+            }
+            state = state * 1664525u + 1013904223u;
+            const size_t index = (state >> 16) % placements.size();
+            const Placement expected = placements[index];
+            uint16_t expected_board[Tetris::BOARD_HEIGHT];
+            std::memcpy(expected_board, game.getPlacementBoard(index), sizeof(expected_board));
+
+            StepResult result = game.stepPlacement(index);
+            pieces++;
+            REQUIRE(result.reward == expected.lines_cleared);
+
+            const BoardFeatures& f = game.getFeatures();
+            size_t mismatches = 0;
+            for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+                mismatches += f.heights[x] != expected.features.heights[x];
+            }
+            mismatches += f.total_holes != expected.features.total_holes;
+            mismatches += f.row_transitions != expected.features.row_transitions;
+            for (int y = 0; y < Tetris::BOARD_HEIGHT; y++) {
+                uint16_t row = 0;
+                for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+                    row |= static_cast<uint16_t>((game.getCell(x, y) != 0) << x);
+                }
+                mismatches += row != expected_board[y];
+            }
+            REQUIRE(mismatches == 0);
+
+            if (result.terminated) {
+                game.reset();
+            }
+        }
+        REQUIRE(pieces > 100);
+    }
+}
+
+TEST_CASE("Snapshot and restore", "[tetris][snapshot]") {
+    TetrisGame game(TimeManager::SIMULATION, 3, 31);
+    uint32_t state = 555;
+    auto next_action = [&state]() {
+        state = state * 1664525u + 1013904223u;
+        return static_cast<int>((state >> 24) % 8);
+    };
+    for (int i = 0; i < 500; i++) {
+        if (game.step(next_action()).terminated) {
+            game.reset();
+        }
+    }
+
+    const GameState saved = game.snapshot();
+    const uint32_t action_state = state;
+    std::vector<float> rewards;
+    std::vector<uint8_t> final_obs;
+    for (int i = 0; i < 300; i++) {
+        StepResult result = game.step(next_action());
+        rewards.push_back(result.reward);
+        if (result.terminated) {
+            game.reset();
+        }
+    }
+    final_obs.assign(game.getObservation().data(), game.getObservation().data() + game.getObservation().size());
+    const int final_score = game.score;
+
+    SECTION("Replaying from a restored game is identical") {
+        TetrisGame fork(TimeManager::SIMULATION, 3, 0);
+        REQUIRE(fork.restore(saved));
+        state = action_state;
+        for (int i = 0; i < 300; i++) {
+            StepResult result = fork.step(next_action());
+            REQUIRE(result.reward == rewards[i]);
+            if (result.terminated) {
+                fork.reset();
+            }
+        }
+        REQUIRE(fork.score == final_score);
+        const Observation& obs = fork.getObservation();
+        REQUIRE(std::equal(final_obs.begin(), final_obs.end(), obs.data()));
+    }
+
+    SECTION("Queue size must match") {
+        TetrisGame other(TimeManager::SIMULATION, 5, 0);
+        REQUIRE_FALSE(other.restore(saved));
+    }
+
+    SECTION("Queues longer than MaxQueue cannot be snapshotted") {
+        TetrisGame long_queue(TimeManager::SIMULATION, GameState::MaxQueue + 1, 0);
+        REQUIRE_THROWS_AS(long_queue.snapshot(), std::invalid_argument);
+    }
+}
+
+TEST_CASE("Piece randomizers", "[tetris][pieces]") {
+    SECTION("COMPAT deals the pre-PieceSource sequences") {
+        // First 16 pieces of TetrisGame(SIMULATION, 3, seed) before PieceSource
+        const std::vector<std::pair<uint32_t, std::vector<int>>> pinned = {
+            {0, {3, 4, 5, 5, 4, 6, 3, 5, 2, 4, 4, 2, 3, 2, 6, 0}},
+            {1, {2, 6, 5, 6, 0, 0, 2, 6, 1, 1, 0, 2, 1, 2, 2, 4}},
+            {42, {2, 5, 6, 1, 5, 5, 4, 4, 1, 3, 1, 0, 0, 3, 6, 2}},
+        };
+        for (const auto& [seed, expected] : pinned) {
+            TetrisGame game(TimeManager::SIMULATION, 3, seed, PieceRandomizer::COMPAT);
+            std::vector<int> dealt = {game.current_piece_type};
+            while (dealt.size() < expected.size()) {
+                dealt.push_back(game.getNextPiece());
+            }
+            REQUIRE(dealt == expected);
+        }
+
+        // reset() keeps drawing from the same generator
+        TetrisGame game(TimeManager::SIMULATION, 3, 42, PieceRandomizer::COMPAT);
+        game.reset();
+        REQUIRE(static_cast<int>(game.current_piece_type) == 5);
+        REQUIRE(static_cast<int>(game.getNextPiece()) == 5);
+        REQUIRE(static_cast<int>(game.getNextPiece()) == 4);
+    }
+
+    SECTION("COMPAT games cannot be snapshotted") {
+        TetrisGame game(TimeManager::SIMULATION, 3, 7, PieceRandomizer::COMPAT);
+        REQUIRE_THROWS_AS(game.snapshot(), std::invalid_argument);
+    }
+
+    SECTION("BAG7 deals every piece once per bag") {
+        PieceSource source(99, PieceRandomizer::BAG7);
+        for (int bag = 0; bag < 20; bag++) {
+            int seen = 0;
+            for (int i = 0; i < 7; i++) {
+                seen |= 1 << source.next();
+            }
+            REQUIRE(seen == 0x7F);
+        }
+    }
+
+    SECTION("UNIFORM covers all pieces evenly") {
+        PieceSource source(7);
+        int counts[8] = {};
+        for (int i = 0; i < 70000; i++) {
+            counts[std::min<int>(source.next(), 7)]++;
+        }
+        REQUIRE(counts[7] == 0);
+        for (int piece = 0; piece < 7; piece++) {
+            const int count = counts[piece];
+            REQUIRE(count > 9500);
+            REQUIRE(count < 10500);
+        }
+    }
+
+    SECTION("Pieces generated ahead survive a snapshot") {
+        TetrisGame game(TimeManager::SIMULATION, 3, 5, PieceRandomizer::BAG7);
+        game.step(Action::DROP);
+        TetrisGame fork(TimeManager::SIMULATION, 3, 0);
+        REQUIRE(fork.restore(game.snapshot()));
+        for (int i = 0; i < 40; i++) {
+            REQUIRE(fork.samplePiece() == game.samplePiece());
+        }
+    }
+}
@@ -0,0 +1,91 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+#include "tetrisGame.h"
+#include "tetrisVecEnv.h"
+
+TEST_CASE("TetrisVecEnv matches TetrisGames with auto-reset", "[vec_env]") {
+    // More threads than a divisor of the env count, so shards are uneven
+    const size_t num_envs = 10;
+    const uint32_t max_steps = 150;
+    TetrisVecEnv env(num_envs, 3, 40, PieceRandomizer::UNIFORM, 3, max_steps);
+    REQUIRE(env.numThreads() == 3);
+
+    std::vector<std::unique_ptr<TetrisGame>> games;
+    std::vector<uint32_t> lengths(num_envs, 0);
+    for (size_t i = 0; i < num_envs; i++) {
+        games.push_back(std::make_unique<TetrisGame>(TimeManager::SIMULATION, 3, 40 + i));
+    }
+
+    std::vector<int32_t> actions(num_envs);
+    uint32_t state = 17;
+    size_t mismatches = 0;
+    size_t terminations = 0;
+    size_t truncations = 0;
+    for (int t = 0; t < 1200; t++) {
+        for (size_t i = 0; i < num_envs; i++) {
+            state = state * 1664525u + 1013904223u;
+            actions[i] = static_cast<int32_t>((state >> 24) % 8);
+        }
+        env.step(actions.data());
+
+        for (size_t i = 0; i < num_envs; i++) {
+            TetrisGame& game = *games[i];
+            const StepResult result = game.step(actions[i]);
+            const bool truncated = !result.terminated && ++lengths[i] >= max_steps;
+            mismatches += env.rewards()[i] != result.reward;
+            mismatches += static_cast<bool>(env.terminated()[i]) != result.terminated;
+            mismatches += static_cast<bool>(env.truncated()[i]) != truncated;
+
+            if (result.terminated || truncated) {
+                const Observation& last = game.getObservation();
+                const float* final_row = env.finalObservations() + i * env.storedObsDim();
+                for (size_t j = 0; j < last.size(); j++) {
+                    mismatches += final_row[j] != static_cast<float>(last.data()[j]);
+                }
+                mismatches += env.finalScores()[i] != game.score;
+                terminations += result.terminated;
+                truncations += truncated;
+                game.reset();
+                lengths[i] = 0;
+            }
+
+            const Observation& obs = game.getObservation();
+            const float* row = env.observations() + i * env.storedObsDim();
+            for (size_t j = 0; j < obs.size(); j++) {
+                mismatches += row[j] != static_cast<float>(obs.data()[j]);
+            }
+        }
+        REQUIRE(mismatches == 0);
+    }
+    REQUIRE(terminations > 0);
+    REQUIRE(truncations > 0);
+}
+
+TEST_CASE("TetrisVecEnv seeds and packed observations", "[vec_env]") {
+    const size_t num_envs = 4;
+    TetrisVecEnv packed(num_envs, 3, 0, PieceRandomizer::BAG7, 2, 0, ObsDtype::PACKED);
+    REQUIRE(packed.storedObsDim() == Observation::packedSize(3));
+
+    const std::vector<uint32_t> seeds = {7, 8, 9, 7};
+    packed.reset(seeds.data());
+    std::vector<int32_t> actions(num_envs, Action::DROP);
+    for (int t = 0; t < 5; t++) {
+        packed.step(actions.data());
+    }
+
+    std::vector<float> unpacked(packed.obsDim());
+    for (size_t i = 0; i < num_envs; i++) {
+        TetrisGame game(TimeManager::SIMULATION, 3, seeds[i], PieceRandomizer::BAG7);
+        for (int t = 0; t < 5; t++) {
+            game.step(Action::DROP);
+        }
+        Observation::unpack(packed.observationBytes() + i * packed.storedObsDim(), 1, 3, unpacked.data());
+        const Observation& obs = game.getObservation();
+        size_t mismatches = 0;
+        for (size_t j = 0; j < obs.size(); j++) {
+            mismatches += unpacked[j] != static_cast<float>(obs.data()[j]);
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
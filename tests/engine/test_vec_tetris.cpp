@@ -0,0 +1,88 @@
+#include <catch2/catch_test_macros.hpp>
+#include <memory>
+#include <vector>
+#include "vecTetris.h"
+#include "tetrisGame.h"
+#include "constants.h"
+
+TEST_CASE("VecTetris matches independent TetrisGames", "[vec][step]") {
+    // 13 envs exercises both full SIMD batches and the scalar tail
+    const size_t num_envs = 13;
+    const uint32_t seed_base = 100;
+    VecTetris vec(num_envs, 3, seed_base);
+
+    std::vector<std::unique_ptr<TetrisGame>> games;
+    for (size_t i = 0; i < num_envs; i++) {
+        games.push_back(std::make_unique<TetrisGame>(TimeManager::SIMULATION, 3, seed_base + i));
+    }
+    REQUIRE(vec.obsSize() == games[0]->getObservation().size());
+
+    std::vector<int> actions(num_envs);
+    std::vector<uint8_t> rendered(vec.obsSize());
+    uint32_t state = 2024;
+    size_t mismatches = 0;
+
+    for (int t = 0; t < 3000; t++) {
+        for (size_t i = 0; i < num_envs; i++) {
+            state = state * 1664525u + 1013904223u;
+            // Favour sideways moves and rotations so boards fill unevenly
+            actions[i] = static_cast<int>((state >> 24) % 9);
+        }
+        vec.step(actions.data());
+
+        for (size_t i = 0; i < num_envs; i++) {
+            StepResult result = games[i]->step(actions[i]);
+            mismatches += vec.rewards()[i] != result.reward;
+            mismatches += static_cast<bool>(vec.terminated()[i]) != result.terminated;
+            mismatches += vec.score[i] != games[i]->score;
+            mismatches += vec.current_x[i] != games[i]->current_x;
+            mismatches += vec.current_y[i] != games[i]->current_y;
+            mismatches += vec.rotation[i] != games[i]->rotation;
+            mismatches += vec.current_piece_type[i] != games[i]->current_piece_type;
+
+            if (t % 11 == 0) {
+                vec.renderObservation(i, rendered.data());
+                const Observation& obs = games[i]->getObservation();
+                for (size_t j = 0; j < obs.size(); j++) {
+                    mismatches += rendered[j] != obs.data()[j];
+                }
+            }
+
+            if (result.terminated) {
+                games[i]->reset();
+                vec.reset(i);
+            }
+        }
+        REQUIRE(mismatches == 0);
+    }
+}
+
+TEST_CASE("VecTetris collision and reset", "[vec][collision]") {
+    VecTetris vec(4, 3, 1);
+
+    SECTION("Pieces fall one row per NOOP step") {
+        std::vector<int> actions(4, static_cast<int>(Action::NOOP));
+        const int start_y = vec.current_y[0];
+        vec.step(actions.data());
+        for (size_t i = 0; i < vec.size(); i++) {
+            REQUIRE(vec.current_y[i] == start_y - 1);
+        }
+    }
+
+    SECTION("Reset clears only the given env") {
+        std::vector<int> actions(4, static_cast<int>(Action::DROP));
+        vec.step(actions.data());
+        vec.reset(2);
+
+        bool other_has_cells = false;
+        for (int y = 0; y < Observation::BoardH; y++) {
+            for (int x = 0; x < Tetris::BOARD_WIDTH; x++) {
+                REQUIRE(vec.getCell(2, x, y) == 0);
+                other_has_cells |= vec.getCell(1, x, y) != 0;
+            }
+        }
+        REQUIRE(other_has_cells);
+        REQUIRE(vec.score[2] == 0);
+        REQUIRE_FALSE(vec.terminated()[2]);
+    }
+}